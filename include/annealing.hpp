@@ -1,26 +1,134 @@
 
 #pragma once
 
+#include "random.hpp"
+#include "control.hpp"
 #include <functional>   // std::function
+#include <cstdint>      // std::uint64_t
 
 namespace Annealing
 {
+    // Parallel execution of the move based variants:
+    // every chain owns a copy of the state with its own random number generator,
+    // seeded by the seed and the index of the chain, and the chains are synchronised
+    // every epoch (simulated) or temperature (compressed), at which point the idle ones
+    // continue from the best solution found so far. Alternatively, the chains of
+    // simulated annealing may form a ladder of temperatures exchanging their solutions.
+    // The result only depends on the seed and the number of chains, not the threads
+    struct Parallel
+    {
+        std::size_t threads = 1UL;      // Worker threads
+
+        std::size_t chains = 1UL;       // Independent chains or replicas
+
+        std::size_t epoch = 10000UL;    // Iterations between synchronisations
+
+        bool tempering = false;         // Replica exchange instead of independent chains
+
+        std::uint64_t seed = 1UL;
+    };
+
+    // The temperature schedule of move based simulated annealing.
+    // Geometric: starting from the specified temperature, which is multiplied by
+    // (1 - cooling) every iteration, the chain is reset to the initial temperature
+    // on every new best and stops once that many iterations pass without one
+    // or the temperature drops below 1.
+    // Adaptive: the initial temperature is calibrated so that the specified ratio of
+    // the sampled uphill moves would be accepted. Every level of iterations, the
+    // temperature is lowered, or raised, by up to a quarter should more, or fewer,
+    // moves be accepted than targeted, the target decaying geometrically down to
+    // the final ratio over a number of levels. Thereafter, should a number of levels
+    // pass without a new best, the chain is reheated to a fraction of the temperature
+    // it was last (re)heated to, the target starting from the same fraction of the
+    // initial ratio, or, once out of reheats, stops. Past the iterations, it stops as well
+    struct Schedule
+    {
+        enum Kind { Geometric, Adaptive } kind = Geometric;
+
+        double temperature = 100000.0;  // Geometric initial temperature
+        double cooling = 0.000005;      // Geometric cooling per iteration
+
+        double acceptance = 0.5;        // Initial acceptance ratio
+        double final = 0.001;           // Final acceptance ratio
+        std::size_t samples = 1000UL;   // Moves sampled for the calibration
+        std::size_t level = 1000UL;     // Iterations per temperature
+        std::size_t levels = 100UL;     // Levels from the initial down to the final ratio
+        std::size_t patience = 20UL;    // Levels without a new best before reheating
+        std::size_t reheats = 3UL;      // Reheats before stopping
+        double reheat = 0.5;            // Fraction of the last (re)heated temperature
+    };
+
+    // The neighbour and cost policies may be any callables of the signatures
+    // T(const T&) and double(const T&) respectively, e.g. a Neighbour and a Cost
+    template <typename T>
+    using Neighbour = std::function<T(const T&)>;
+
     template <typename T>
+    using Cost = std::function<double(const T&)>;
+
+    template <typename T, typename N, typename C>
     T simulated(
         const T&,
-        const std::function<T(const T&)>&,
-        const std::function<double(const T&)>&,
+        const N&,
+        const C&,
         double,
         double,
         std::size_t
     );
 
-    template <typename T>
+    // Move based simulated annealing operating in place on a copyable state S,
+    // which is expected to provide the following members:
+    // double cost() const  -- The cost of the current solution
+    // double propose()     -- Propose a random move and return its cost delta
+    // void apply()         -- Apply the last proposed move
+    // void save()          -- Remember the current solution as the best one
+    // void restore()       -- Revert to the best solution remembered
+    // Random& random()     -- The random number generator of the state
+    // On return, the state holds the best solution found.
+    // The control is checked and the progress reported at every synchronisation
+    template <typename S>
+    void simulated(
+        S&,
+        double,
+        double,
+        std::size_t,
+        const Parallel& = Parallel(),
+        const Control& = Control()
+    );
+
+    // Likewise, following the specified schedule. In the case of replica exchange,
+    // an adaptive schedule only calibrates the temperatures of the hottest and the
+    // coldest replica to the initial and final acceptance ratio respectively
+    template <typename S>
+    void simulated(
+        S&,
+        const Schedule&,
+        std::size_t,
+        const Parallel& = Parallel(),
+        const Control& = Control()
+    );
+
+    // The initial temperature and maximum pressure of compressed annealing.
+    // As they only depend on the scale of the costs and penalties, those of an instance
+    // may be reused by later runs over similar instances in order to skip the calibration
+    struct Calibration
+    {
+        double temperature = 0.0;
+
+        double MAXPRESSURE = 0.0;
+
+        bool calibrated() const { return temperature > 0.0; }
+    };
+
+    // The penalty policy is a callable of the same signature as the cost.
+    // A feasible neighbour exerts no pressure on the calibration of the maximum pressure;
+    // should every neighbour sampled be feasible, the pressure stays at its initial value
+    template <typename T, typename N, typename C, typename P>
     T compressed(
         const T& initial,
-        const std::function<T(const T&)>&,
-        const std::function<double(const T&)>&,
-        const std::function<double(const T&)>&,
+        const N&,
+        const C&,
+        const P&,
         double,
         double,
         double,
@@ -32,6 +140,39 @@ namespace Annealing
         std::size_t,
         std::size_t
     );
+
+    // Move based compressed annealing operating in place on a copyable state S,
+    // which is expected to provide the following members:
+    // double cost() const                  -- The cost of the current solution
+    // double penalty() const               -- The penalty of the current solution
+    // std::pair<double, double> propose()  -- Propose a random move and return its cost and penalty delta
+    // void apply()                         -- Apply the last proposed move
+    // void save()                          -- Remember the current solution as the best one
+    // void restore()                       -- Revert to the best solution remembered
+    // Random& random()                     -- The random number generator of the state
+    // On return, the state holds the best solution found.
+    // The control is checked and the progress reported at every temperature.
+    // The neighbour pairs and trial loops of the calibration are shared amongst the chains,
+    // unless a calibration is provided, in which case it is skipped altogether.
+    // Returns the calibration used, or an uncalibrated one should the budget
+    // have cut the calibration short
+    template <typename S>
+    Calibration compressed(
+        S&,
+        double,
+        double,
+        double,
+        double,
+        double,
+        std::size_t,
+        std::size_t,
+        std::size_t,
+        std::size_t,
+        std::size_t,
+        const Parallel& = Parallel(),
+        const Control& = Control(),
+        const Calibration& = Calibration()
+    );
 }
 
 #include "annealing.ipp"
@@ -1,16 +1,20 @@
 
 #pragma once
 
-#include <functional>   // std::function
-#include <cmath>        // std::exp
+#include "threadpool.hpp"
+#include "instrument.hpp"
+#include <cmath>        // std::exp, std::pow
 #include <cstdlib>      // std::rand
 #include <ctime>        // std::time
+#include <utility>      // std::pair, std::swap
+#include <vector>       // std::vector
+#include <algorithm>    // std::min_element, std::all_of, std::min, std::max
 
-template <typename T>
+template <typename T, typename N, typename C>
 T Annealing::simulated(
     const T& initial,
-    const std::function<T(const T&)>& neighbour,
-    const std::function<double(const T&)>& cost,
+    const N& neighbour,
+    const C& cost,
     double temperature,
     double cooling,
     std::size_t iterations
@@ -31,16 +35,24 @@ T Annealing::simulated(
     T current    = initial,       best  = current;
     double ccost = cost(current), bcost = ccost;
 
+    INSTRUMENT(Instrument::Probe probe; std::size_t proposals = 0UL;)
+
     std::size_t counter = 0UL;
     do
     {
         T next = neighbour(current);
 
+        INSTRUMENT(probe.lap(&Instrument::Sample::generate);)
+
         const double ncost = cost(next);
 
+        INSTRUMENT(probe.lap(&Instrument::Sample::evaluate); probe.iterated();)
+
         if (probability(ccost, ncost) > rand01())
         {
             current = next; ccost = ncost;
+
+            INSTRUMENT(probe.lap(&Instrument::Sample::apply); probe.accepted();)
         }
 
         if (ccost < bcost)
@@ -48,23 +60,34 @@ T Annealing::simulated(
             best = current; bcost = ccost;
             
             counter = 0UL; temperature = _temperature;
+
+            INSTRUMENT(probe.improved();)
         }
+
+        INSTRUMENT
+        (
+            if (++proposals % Instrument::interval == 0UL)
+            {
+                probe.end(); probe.record("simulated", proposals, temperature, 0.0, ccost, 0.0); probe.begin();
+            }
+        )
     } while (counter++ < iterations && (temperature *= (1.0 - cooling)) > 1.0);
 
+    INSTRUMENT(probe.end(); probe.record("simulated", proposals, temperature, 0.0, ccost, 0.0);)
+
     return best;
 }
-
 // A compressed annealing approach to the traveling salesman problem with time windows
 // by
 // Jeffrey W. Ohlmann
 // Barrett W. Thomas
 // @ https://www.researchgate.net/publication/228633085_A_compressed_annealing_approach_to_the_traveling_salesman_problem_with_time_windows
-template <typename T>
+template <typename T, typename N, typename C, typename P>
 T Annealing::compressed(
     const T& initial,
-    const std::function<T(const T&)>& neighbour,
-    const std::function<double(const T&)>& cost,
-    const std::function<double(const T&)>& penalty,
+    const N& neighbour,
+    const C& cost,
+    const P& penalty,
     double COOLING,                                 // (1)  Cooling Coefficient
     double ACCEPTANCE,                              // (2)  Initial Acceptance Ratio
     double PRESSURE0,                               // (3)  Initial Pressure
@@ -89,8 +112,9 @@ T Annealing::compressed(
 
         dv += std::abs(e2 - e1);
 
-        const double c1pressure = (c1 / p1) * (PCR / (1.0 - PCR));
-        const double c2pressure = (c2 / p2) * (PCR / (1.0 - PCR));
+        // A feasible neighbour exerts no pressure
+        const double c1pressure = p1 > 0.0 ? (c1 / p1) * (PCR / (1.0 - PCR)) : 0.0;
+        const double c2pressure = p2 > 0.0 ? (c2 / p2) * (PCR / (1.0 - PCR)) : 0.0;
 
         if (c1pressure > MAXPRESSURE)
             MAXPRESSURE = c1pressure;
@@ -99,7 +123,10 @@ T Annealing::compressed(
             MAXPRESSURE = c2pressure;
     }
 
-    double temperature = dv / std::log(1.0 / ACCEPTANCE);
+    // The mean absolute delta of the pairs sampled
+    dv /= static_cast<double>(std::max<std::size_t>(1UL, 2UL * TNP));
+
+    double temperature = dv > 0.0 ? dv / std::log(1.0 / ACCEPTANCE) : 1.0;
 
     auto rand01 = []()
     {
@@ -146,22 +173,32 @@ T Annealing::compressed(
     double ccost = cost(current),    bcost = ccost;
     double cpnlt = penalty(current), bpnlt = cpnlt;
 
+    INSTRUMENT(Instrument::Probe probe;)
+
     double pressure = PRESSURE0;
     for (std::size_t k = 0UL, idle = 0UL; ; k++, idle++)
     {
+        INSTRUMENT(probe.begin();)
+
         for (std::size_t i = 0; i < IPT; i++)
         {
             T next = neighbour(current);
 
+            INSTRUMENT(probe.lap(&Instrument::Sample::generate);)
+
             const double ncost = cost(next);
             const double npnlt = penalty(next);
 
+            INSTRUMENT(probe.lap(&Instrument::Sample::evaluate); probe.iterated();)
+
             const double ceval = ccost + pressure * cpnlt;
             const double neval = ncost + pressure * npnlt;
 
             if (probability(ceval, neval) > rand01())
             {
                 current = next; ccost = ncost; cpnlt = npnlt;
+
+                INSTRUMENT(probe.lap(&Instrument::Sample::apply); probe.accepted();)
             }
 
             if ((cpnlt <= bpnlt) && (ccost < bcost))
@@ -169,16 +206,705 @@ T Annealing::compressed(
                 best = current; bcost = ccost; bpnlt = cpnlt;
 
                 idle = 0UL;
+
+                INSTRUMENT(probe.improved();)
             }
         }
 
+        INSTRUMENT(probe.end(); probe.record("compressed", k, temperature, pressure, ccost, cpnlt);)
+
         if (k >= MTC && idle >= ITC)
             break;
         
         temperature *= COOLING;
 
-        pressure = MAXPRESSURE * (1.0 - ((MAXPRESSURE - PRESSURE0) / MAXPRESSURE) * std::exp(-1.0 * COMPRESSION * k));
+        if (MAXPRESSURE > 0.0)
+            pressure = MAXPRESSURE * (1.0 - ((MAXPRESSURE - PRESSURE0) / MAXPRESSURE) * std::exp(-1.0 * COMPRESSION * k));
     }
 
     return best;
 }
+
+// Move based variants:
+namespace Annealing
+{
+    // A simulated annealing chain advanced a number of iterations at a time
+    template <typename S>
+    struct SimulatedChain
+    {
+        S state;
+
+        double initial, temperature, cooling;
+
+        std::size_t iterations, counter, proposals;
+
+        double ccost, bcost;
+
+        // The best solution is only copied when about to be left behind
+        bool atBest;
+
+        bool improved, done;
+
+        INSTRUMENT(Instrument::Probe probe;)
+
+        // The adaptive schedule followed, if any, and the progress along it
+        const Schedule * schedule;
+
+        double heated;
+
+        std::size_t accepted, step, idle, reheats;
+
+        SimulatedChain(const S& state, double temperature, double cooling, std::size_t iterations, const Schedule * schedule = nullptr)
+        :
+        state(state),
+        initial(temperature), temperature(temperature), cooling(cooling),
+        iterations(iterations), counter(0UL), proposals(0UL),
+        ccost(this->state.cost()), bcost(ccost),
+        atBest(true), improved(false), done(false),
+        schedule(schedule), heated(temperature), accepted(0UL), step(0UL), idle(0UL), reheats(0UL)
+        {
+        }
+
+        // Advances the schedule by an iteration and returns whether the chain is done
+        bool cool()
+        {
+            // A chain that is not cooled down only stops once idle
+            if (!schedule)
+                return !(counter++ < iterations && (cooling <= 0.0 || (temperature *= (1.0 - cooling)) > 1.0));
+
+            const std::size_t level = std::max<std::size_t>(1UL, schedule->level);
+
+            if (++counter % level != 0UL)
+                return counter >= iterations;
+
+            // Every reheat targets a proportionally lower initial acceptance ratio
+            const double start = schedule->acceptance * std::pow(schedule->reheat, static_cast<double>(reheats));
+
+            const double progress =
+            std::min(1.0, static_cast<double>(++step) / static_cast<double>(std::max<std::size_t>(1UL, schedule->levels)));
+
+            const double target = start * std::pow(schedule->final / start, progress);
+
+            // Cooler, should more moves have been accepted than targeted, or else warmer
+            const double ratio =
+            (target * static_cast<double>(level) + 1.0) / (static_cast<double>(accepted) + 1.0);
+
+            temperature *= std::min(1.25, std::max(0.8, ratio)); accepted = 0UL;
+
+            if (++idle > schedule->patience && progress >= 1.0)
+            {
+                if (reheats >= schedule->reheats)
+                    return true;
+
+                heated *= schedule->reheat; temperature = std::max(temperature, heated);
+
+                reheats++; step = 0UL; idle = 0UL;
+            }
+
+            return counter >= iterations;
+        }
+
+        // Returns early, should the monitor expire
+        void advance(std::size_t steps, const Monitor& monitor)
+        {
+            INSTRUMENT(probe.begin(); const std::size_t first = proposals;)
+
+            for (std::size_t s = 0UL; s < steps && !done; s++, proposals++)
+            {
+                if ((s & 0xFFUL) == 0xFFUL && monitor.expired())
+                    break;
+
+                const double delta = state.propose();
+
+                INSTRUMENT(probe.lap(&Instrument::Sample::evaluate); probe.iterated();)
+
+                if (delta < 0.0 || std::exp(-delta / temperature) > state.random().uniform())
+                {
+                    if (atBest)
+                    {
+                        state.save(); atBest = false;
+                    }
+
+                    state.apply(); ccost = state.cost(); accepted++;
+
+                    INSTRUMENT(probe.lap(&Instrument::Sample::apply); probe.accepted();)
+                }
+
+                if (ccost < bcost)
+                {
+                    atBest = true; bcost = ccost; improved = true;
+
+                    if (schedule)
+                        idle = 0UL;
+                    else
+                    {
+                        counter = 0UL; temperature = initial;
+                    }
+
+                    INSTRUMENT(probe.improved();)
+                }
+
+                done = cool();
+            }
+
+            INSTRUMENT
+            (
+                probe.end();
+
+                if (proposals > first)
+                    probe.record("simulated", proposals, temperature, 0.0, ccost, 0.0);
+            )
+        }
+
+        // Continue from the best solution of another chain
+        void adopt(const SimulatedChain& other)
+        {
+            const Random random = state.random();
+
+            state = other.state; state.random() = random;
+
+            if (!other.atBest)
+                state.restore();
+
+            ccost = bcost = other.bcost; atBest = true;
+        }
+
+        // Exchange the solutions of two replicas
+        void exchange(SimulatedChain& other)
+        {
+            std::swap(state, other.state);
+            std::swap(ccost, other.ccost);
+            std::swap(bcost, other.bcost);
+            std::swap(atBest, other.atBest);
+        }
+
+        void finish()
+        {
+            if (!atBest)
+                state.restore();
+
+            ccost = bcost; atBest = true;
+        }
+    };
+
+    // A compressed annealing chain advanced a temperature at a time
+    template <typename S>
+    struct CompressedChain
+    {
+        S state;
+
+        double temperature, pressure, MAXPRESSURE;
+
+        double PRESSURE0, COOLING, COMPRESSION;
+
+        std::size_t IPT, MTC, ITC, k, idle, proposals;
+
+        double bcost, bpnlt;
+
+        bool atBest, improved, done;
+
+        INSTRUMENT(Instrument::Probe probe;)
+
+        CompressedChain
+        (
+            const S& state,
+            double temperature,
+            double MAXPRESSURE,
+            double PRESSURE0,
+            double COOLING,
+            double COMPRESSION,
+            std::size_t IPT,
+            std::size_t MTC,
+            std::size_t ITC
+        )
+        :
+        state(state),
+        temperature(temperature), pressure(PRESSURE0), MAXPRESSURE(MAXPRESSURE),
+        PRESSURE0(PRESSURE0), COOLING(COOLING), COMPRESSION(COMPRESSION),
+        IPT(IPT), MTC(MTC), ITC(ITC), k(0UL), idle(0UL), proposals(0UL),
+        bcost(this->state.cost()), bpnlt(this->state.penalty()),
+        atBest(true), improved(false), done(false)
+        {
+        }
+
+        // Whether the best solution of this chain is preferable to that of the other
+        bool operator<(const CompressedChain& other) const
+        {
+            return bpnlt < other.bpnlt || (bpnlt == other.bpnlt && bcost < other.bcost);
+        }
+
+        // Returns early, without cooling down, should the monitor expire
+        void advance(const Monitor& monitor)
+        {
+            improved = false;
+
+            INSTRUMENT(probe.begin();)
+
+            bool expired = false;
+
+            for (std::size_t i = 0; i < IPT && !done; i++, proposals++)
+            {
+                if ((i & 0xFFUL) == 0xFFUL && monitor.expired())
+                {
+                    expired = true; break;
+                }
+
+                const std::pair<double, double> delta = state.propose();
+
+                INSTRUMENT(probe.lap(&Instrument::Sample::evaluate); probe.iterated();)
+
+                const double ndelta = delta.first + pressure * delta.second;
+
+                if (ndelta < 0.0 || std::exp(-ndelta / temperature) > state.random().uniform())
+                {
+                    if (atBest)
+                    {
+                        state.save(); atBest = false;
+                    }
+
+                    state.apply();
+
+                    INSTRUMENT(probe.lap(&Instrument::Sample::apply); probe.accepted();)
+                }
+
+                const double ccost = state.cost(), cpnlt = state.penalty();
+
+                if ((cpnlt <= bpnlt) && (ccost < bcost))
+                {
+                    atBest = true; bcost = ccost; bpnlt = cpnlt; improved = true;
+
+                    idle = 0UL;
+
+                    INSTRUMENT(probe.improved();)
+                }
+            }
+
+            INSTRUMENT(probe.end(); probe.record("compressed", k, temperature, pressure, state.cost(), state.penalty());)
+
+            if (expired)
+                return;
+
+            if (k >= MTC && idle >= ITC)
+            {
+                done = true; return;
+            }
+
+            temperature *= COOLING;
+
+            if (MAXPRESSURE > 0.0)
+                pressure = MAXPRESSURE * (1.0 - ((MAXPRESSURE - PRESSURE0) / MAXPRESSURE) * std::exp(-1.0 * COMPRESSION * k));
+
+            k++; idle++;
+        }
+
+        void adopt(const CompressedChain& other)
+        {
+            const Random random = state.random();
+
+            state = other.state; state.random() = random;
+
+            if (!other.atBest)
+                state.restore();
+
+            bcost = other.bcost; bpnlt = other.bpnlt; atBest = true;
+        }
+
+        void finish()
+        {
+            if (!atBest)
+                state.restore();
+
+            atBest = true;
+        }
+    };
+
+    // The mean of the positive cost deltas of the moves sampled from a copy of the state,
+    // or 1 should none of them be uphill
+    template <typename S>
+    double uphill(S state, std::size_t samples, const Random& random)
+    {
+        state.random() = random;
+
+        double sum = 0.0; std::size_t count = 0UL;
+
+        for (std::size_t s = 0UL; s < samples; s++)
+        {
+            const double delta = state.propose();
+
+            if (delta > 0.0)
+            {
+                sum += delta; count++;
+            }
+        }
+
+        return count > 0UL ? sum / static_cast<double>(count) : 1.0;
+    }
+
+    // Step 1 of compressed annealing; returns the initial temperature and the maximum pressure
+    // and leaves the state at the initial solution, which is remembered as the best one.
+    // Every chain samples its share of the neighbour pairs on a copy of the state, and then
+    // the trial loops of as many successive temperatures are run at once, the lowest one
+    // reaching the acceptance ratio being kept. The result only depends on the seed
+    // and the number of chains. Should the monitor expire, the estimates are based
+    // on the samples drawn so far
+    template <typename S>
+    Calibration calibrate
+    (
+        S& state,
+        double ACCEPTANCE,
+        double PRESSURE0,
+        double PCR,
+        std::size_t TLI,
+        std::size_t TNP,
+        const Parallel& parallel,
+        const Monitor& monitor,
+        bool& complete
+    )
+    {
+        // The initial solution is remembered in order to return to it
+        state.save();
+
+        const double c0 = state.cost(), p0 = state.penalty();
+
+        const std::size_t count = std::max<std::size_t>(1UL, parallel.chains);
+
+        // The chains are given streams following those of the actual algorithm
+        std::vector<S> states(count, state);
+        for (std::size_t c = 0UL; c < count; c++)
+            states[c].random() = Random(parallel.seed, count + c);
+
+        ThreadPool pool(parallel.threads > 1UL && count > 1UL ? std::min(parallel.threads, count) : 0UL);
+
+        // Determine Initial Temperature & Maximum Pressure:
+        std::vector<double> dvs(count, 0.0), pressures(count, 0.0);
+
+        std::vector<std::size_t> pairs(count, 0UL);
+
+        pool.parallel(count, [&](std::size_t c)
+        {
+            S& state = states[c];
+
+            const std::size_t share = 2UL * TNP * (c + 1UL) / count - 2UL * TNP * c / count;
+
+            std::size_t r = 0UL;
+            for (; r < share; r++)
+            {
+                if ((r & 0xFFUL) == 0xFFUL && monitor.expired())
+                    break;
+
+                const std::pair<double, double> m1 = state.propose(); state.apply();
+                const std::pair<double, double> m2 = state.propose(); state.restore();
+
+                const double c1 = c0 + m1.first, p1 = p0 + m1.second, e1 = c1 + PRESSURE0 * p1;
+                const double c2 = c1 + m2.first, p2 = p1 + m2.second, e2 = c2 + PRESSURE0 * p2;
+
+                dvs[c] += std::abs(e2 - e1);
+
+                // A feasible neighbour exerts no pressure
+                const double c1pressure = p1 > 0.0 ? (c1 / p1) * (PCR / (1.0 - PCR)) : 0.0;
+                const double c2pressure = p2 > 0.0 ? (c2 / p2) * (PCR / (1.0 - PCR)) : 0.0;
+
+                pressures[c] = std::max(pressures[c], std::max(c1pressure, c2pressure));
+            }
+
+            pairs[c] = r;
+        });
+
+        double dv = 0.0, MAXPRESSURE = 0.0; std::size_t sampled = 0UL;
+        for (std::size_t c = 0UL; c < count; c++)
+        {
+            dv += dvs[c]; MAXPRESSURE = std::max(MAXPRESSURE, pressures[c]); sampled += pairs[c];
+        }
+
+        // The mean absolute delta of the pairs sampled
+        if (sampled > 0UL)
+            dv /= static_cast<double>(sampled);
+
+        // Not a single move makes a difference, in which case any temperature would do
+        double temperature = dv > 0.0 ? dv / std::log(1.0 / ACCEPTANCE) : 1.0;
+
+        std::vector<std::size_t> accepted(count), iterations(count);
+
+        for (;;)
+        {
+            pool.parallel(count, [&](std::size_t c)
+            {
+                S& state = states[c]; state.restore();
+
+                const double trial = temperature * std::pow(1.5, static_cast<double>(c));
+
+                accepted[c] = 0UL;
+
+                std::size_t it = 0UL;
+                for (; it < TLI; it++)
+                {
+                    if ((it & 0xFFUL) == 0xFFUL && monitor.expired())
+                        break;
+
+                    const std::pair<double, double> delta = state.propose();
+
+                    const double ndelta = delta.first + PRESSURE0 * delta.second;
+
+                    if (ndelta < 0.0 || std::exp(-ndelta / trial) > state.random().uniform())
+                    {
+                        state.apply();
+
+                        accepted[c]++;
+                    }
+                }
+
+                iterations[c] = it;
+            });
+
+            for (std::size_t c = 0UL; c < count; c++)
+                if (iterations[c] < TLI || (static_cast<double>(accepted[c]) / static_cast<double>(TLI)) >= ACCEPTANCE)
+                {
+                    // Should the budget have cut the sampling or the trial short, the calibration
+                    // still serves the run at hand but is not to be reused
+                    complete = sampled == 2UL * TNP && iterations[c] == TLI;
+
+                    Calibration calibration;
+
+                    calibration.temperature = temperature * std::pow(1.5, static_cast<double>(c));
+                    calibration.MAXPRESSURE = MAXPRESSURE;
+
+                    return calibration;
+                }
+
+            temperature *= std::pow(1.5, static_cast<double>(count));
+        }
+    }
+}
+
+template <typename S>
+void Annealing::simulated(
+    S& state,
+    double temperature,
+    double cooling,
+    std::size_t iterations,
+    const Parallel& parallel,
+    const Control& control
+)
+{
+    Schedule schedule;
+
+    schedule.kind        = Schedule::Geometric;
+    schedule.temperature = temperature;
+    schedule.cooling     = cooling;
+
+    simulated(state, schedule, iterations, parallel, control);
+}
+
+template <typename S>
+void Annealing::simulated(
+    S& state,
+    const Schedule& schedule,
+    std::size_t iterations,
+    const Parallel& parallel,
+    const Control& control
+)
+{
+    Monitor monitor(control);
+
+    const std::size_t count = std::max<std::size_t>(1UL, parallel.chains);
+
+    const bool tempering = parallel.tempering && count > 1UL;
+
+    const bool adaptive = schedule.kind == Schedule::Adaptive;
+
+    double hottest = schedule.temperature, coldest = 1.0;
+
+    if (adaptive)
+    {
+        // The temperatures at which the initial and the final ratio of uphill moves would be accepted
+        const double delta = uphill(state, schedule.samples, Random(parallel.seed, count + 1UL));
+
+        hottest = delta / std::log(1.0 / schedule.acceptance);
+        coldest = delta / std::log(1.0 / schedule.final);
+    }
+
+    std::vector<SimulatedChain<S>> chains; chains.reserve(count);
+    for (std::size_t c = 0UL; c < count; c++)
+    {
+        // The replicas are spaced geometrically from the hottest temperature down to the coldest
+        const double t = tempering ?
+        hottest * std::pow(coldest / hottest, static_cast<double>(c) / static_cast<double>(count - 1UL)) :
+        hottest;
+
+        chains.emplace_back
+        (
+            state,
+            t,
+            tempering ? 0.0 : schedule.cooling,
+            iterations,
+            adaptive && !tempering ? &schedule : nullptr
+        );
+
+        chains.back().state.random() = Random(parallel.seed, c);
+
+        INSTRUMENT(chains.back().probe.chain = c;)
+    }
+
+    // Used for the replica exchanges
+    Random random(parallel.seed, count);
+
+    ThreadPool pool(parallel.threads > 1UL && count > 1UL ? std::min(parallel.threads, count) : 0UL);
+
+    const std::size_t epoch = std::max<std::size_t>(1UL, parallel.epoch);
+
+    auto best = [&chains]()
+    {
+        return std::min_element
+        (
+            chains.begin(),
+            chains.end(),
+            [](const SimulatedChain<S>& A, const SimulatedChain<S>& B) { return A.bcost < B.bcost; }
+        );
+    };
+
+    for (std::size_t round = 0UL, proposals = 0UL; ; round++)
+    {
+        // The last epoch is shortened so as not to exceed the iteration limit
+        const std::size_t steps = std::min(epoch, std::max<std::size_t>(1UL, (control.iterations - proposals) / count));
+
+        pool.parallel(count, [&chains, &monitor, steps](std::size_t c)
+        {
+            chains[c].improved = false; chains[c].advance(steps, monitor);
+        });
+
+        proposals = 0UL;
+        for (const auto& chain : chains)
+            proposals += chain.proposals;
+
+        const bool finished = monitor.stop(proposals) || std::all_of
+        (
+            chains.begin(),
+            chains.end(),
+            [](const SimulatedChain<S>& chain) { return chain.done; }
+        );
+
+        monitor.report(best()->bcost, 0.0, best()->temperature, proposals, finished);
+
+        if (finished)
+            break;
+
+        if (tempering)
+        {
+            // Alternate between exchanging the even and the odd pairs of neighbouring replicas
+            for (std::size_t c = round % 2UL; c + 1UL < count; c += 2UL)
+            {
+                const double exponent =
+                (chains[c].ccost - chains[c + 1UL].ccost) *
+                (1.0 / chains[c].temperature - 1.0 / chains[c + 1UL].temperature);
+
+                if (exponent >= 0.0 || std::exp(exponent) > random.uniform())
+                    chains[c].exchange(chains[c + 1UL]);
+            }
+        }
+        else
+        {
+            // Idle chains continue from the best solution found so far
+            const std::size_t b = best() - chains.begin();
+
+            for (std::size_t c = 0UL; c < count; c++)
+                if (c != b && !chains[c].done && !chains[c].improved)
+                    chains[c].adopt(chains[b]);
+        }
+    }
+
+    auto chain = best();
+
+    chain->finish();
+
+    state = std::move(chain->state);
+}
+
+template <typename S>
+Annealing::Calibration Annealing::compressed(
+    S& state,
+    double COOLING,                                 // (1)  Cooling Coefficient
+    double ACCEPTANCE,                              // (2)  Initial Acceptance Ratio
+    double PRESSURE0,                               // (3)  Initial Pressure
+    double COMPRESSION,                             // (4)  Compression Coefficient
+    double PCR,                                     // (5)  Pressure Cap Ratio
+    std::size_t IPT,                                // (6)  Iterations per temperature
+    std::size_t MTC,                                // (7)  Minimum number of temperature changes
+    std::size_t ITC,                                // (8)  Maximum idle temperature changes
+    std::size_t TLI,                                // (9)  Trial loop of iterations
+    std::size_t TNP,                                // (10) Trial neighbour pairs
+    const Parallel& parallel,
+    const Control& control,
+    const Calibration& calibrated
+)
+{
+    Monitor monitor(control);
+
+    const std::size_t count = std::max<std::size_t>(1UL, parallel.chains);
+
+    // Step 1: Parameter Calibration
+    bool complete = true;
+
+    const Calibration calibration = calibrated.calibrated() ?
+    calibrated :
+    calibrate(state, ACCEPTANCE, PRESSURE0, PCR, TLI, TNP, parallel, monitor, complete);
+
+    // Step 2: Actual Algorithm
+    std::vector<CompressedChain<S>> chains; chains.reserve(count);
+    for (std::size_t c = 0UL; c < count; c++)
+    {
+        chains.emplace_back
+        (
+            state,
+            calibration.temperature,
+            calibration.MAXPRESSURE,
+            PRESSURE0,
+            COOLING,
+            COMPRESSION,
+            IPT,
+            MTC,
+            ITC
+        );
+
+        chains.back().state.random() = Random(parallel.seed, c);
+
+        INSTRUMENT(chains.back().probe.chain = c;)
+    }
+
+    ThreadPool pool(parallel.threads > 1UL && count > 1UL ? std::min(parallel.threads, count) : 0UL);
+
+    for (std::size_t proposals = 0UL; ; )
+    {
+        pool.parallel(count, [&chains, &monitor](std::size_t c) { chains[c].advance(monitor); });
+
+        proposals = 0UL;
+        for (const auto& chain : chains)
+            proposals += chain.proposals;
+
+        // Chains idle at the last temperature continue from the best solution found so far
+        const std::size_t b = std::min_element(chains.begin(), chains.end()) - chains.begin();
+
+        const bool finished = monitor.stop(proposals) || std::all_of
+        (
+            chains.begin(),
+            chains.end(),
+            [](const CompressedChain<S>& chain) { return chain.done; }
+        );
+
+        monitor.report(chains[b].bcost, chains[b].bpnlt, chains[b].temperature, proposals, finished);
+
+        if (finished)
+            break;
+
+        for (std::size_t c = 0UL; c < count; c++)
+            if (c != b && !chains[c].done && !chains[c].improved)
+                chains[c].adopt(chains[b]);
+    }
+
+    auto best = std::min_element(chains.begin(), chains.end());
+
+    best->finish();
+
+    state = std::move(best->state);
+
+    return complete ? calibration : Calibration();
+}
@@ -0,0 +1,102 @@
+
+#pragma once
+
+#include "vector2.hpp"
+#include "matrix.hpp"
+#include <string>       // std::string
+#include <vector>       // std::vector
+#include <utility>      // std::pair
+#include <memory>       // std::shared_ptr, std::enable_shared_from_this
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint32_t, std::uint64_t
+
+// An instance stored in a compact binary file, which is memory mapped read-only,
+// so that loading it copies nothing and every process mapping the same file
+// shares its pages. The stops, the depot first, are described by their coordinates,
+// service times and timewindows (in seconds, as TStamp::seconds) and, optionally,
+// by the durations between them, laid out as a dense DistanceMatrix.
+// The rounding of the euclidean durations, as by the TSPLIB edge weight type,
+// is recorded whether or not they are stored, for them to be evaluated alike.
+// Layout, in native byte order, every section starting at a 64-byte boundary:
+//     Header
+//     double x[n], y[n], service[n], open[n], close[n]
+//     double durations[n][DistanceMatrix::stride(n)]     (if Header::matrix)
+// Meant to be owned by a std::shared_ptr, which the durations share
+class BinaryInstance : public std::enable_shared_from_this<BinaryInstance>
+{
+public:
+
+    // How the euclidean durations are rounded
+    enum Rounding : std::uint32_t { none = 0U, nearest = 1U, up = 2U };
+
+    struct Header
+    {
+        char magic[8];
+
+        std::uint32_t version, matrix;
+
+        std::uint64_t size, stride;
+
+        double departure;
+
+        std::uint32_t rounding;
+
+        char reserved[20];
+    };
+
+    static constexpr std::uint32_t version = 1U;
+
+private:
+
+    void * _address;
+
+    std::size_t _length;
+
+    const Header * _header;
+
+    const double * _x, * _y, * _service, * _open, * _close, * _durations;
+
+public:
+
+    // Throws std::runtime_error should the file be missing or malformed
+    BinaryInstance(const std::string&);
+
+    BinaryInstance(const BinaryInstance&) = delete;
+    BinaryInstance& operator=(const BinaryInstance&) = delete;
+
+    ~BinaryInstance();
+
+    std::size_t size() const { return _header->size; }
+
+    double departure() const { return _header->departure; }
+
+    Rounding rounding() const { return static_cast<Rounding>(_header->rounding); }
+
+    Vector2 position(std::size_t i) const { return Vector2(_x[i], _y[i]); }
+
+    double service(std::size_t i) const { return _service[i]; }
+
+    std::pair<double, double> window(std::size_t i) const { return std::make_pair(_open[i], _close[i]); }
+
+    bool matrix() const { return _durations != nullptr; }
+
+    // The durations, sharing the ownership of the instance, or nullptr if not stored
+    std::shared_ptr<const double> durations() const;
+
+    // The distance rounded as specified
+    static double round(double, Rounding);
+
+    // The durations are evaluated, row by row, by the specified number of threads
+    // unless the function is empty. Throws std::runtime_error should writing fail
+    static void write
+    (
+        const std::string&,
+        const std::vector<Vector2>&,
+        const std::vector<double>&,
+        const std::vector<std::pair<double, double>>&,
+        double,
+        Rounding,
+        const DistanceMatrix::Function& = DistanceMatrix::Function(),
+        std::size_t = 1UL
+    );
+};
@@ -0,0 +1,100 @@
+
+#pragma once
+
+#include "deadline.hpp"
+#include <functional>   // std::function
+#include <memory>       // std::shared_ptr, std::make_shared
+#include <atomic>       // std::atomic
+#include <limits>       // std::numeric_limits
+#include <cstddef>      // std::size_t
+
+// A flag, shared amongst its copies, by means of which a running solver is asked to stop.
+// Solvers poll it cooperatively and return the best solution found so far
+class CancelToken
+{
+    std::shared_ptr<std::atomic<bool>> _cancelled;
+
+public:
+
+    CancelToken() : _cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { _cancelled->store(true, std::memory_order_relaxed); }
+
+    bool cancelled() const { return _cancelled->load(std::memory_order_relaxed); }
+};
+
+// A snapshot of a running solver; the temperature of local searches is 0
+struct Progress
+{
+    double cost, penalty, temperature;
+
+    std::size_t iterations;                 // Iterations performed so far
+
+    double rate;                            // Iterations per second since the last report
+
+    double elapsed;                         // Seconds since the solver started
+};
+
+// The limits of a solver run and the means of observing and stopping it.
+// Annealing counts every proposed move as an iteration, whereas local searches
+// count every improving move applied. The progress callback is invoked
+// from the thread that called the solver, at most once every interval
+struct Control
+{
+    double seconds = std::numeric_limits<double>::infinity();               // Wall clock budget
+
+    std::size_t iterations = std::numeric_limits<std::size_t>::max();       // Iteration limit
+
+    double interval = 0.1;                                                  // Seconds between reports
+
+    std::function<void(const Progress&)> progress;
+
+    CancelToken cancel;
+};
+
+// Keeps track of a Control on behalf of a running solver
+class Monitor
+{
+    const Control& _control;
+
+    Deadline _deadline;
+
+    double _reported;
+
+    std::size_t _iterations;
+
+public:
+
+    explicit Monitor(const Control& _control)
+    :
+    _control(_control), _deadline(_control.seconds), _reported(0.0), _iterations(0UL)
+    {
+    }
+
+    double elapsed() const { return _deadline.elapsed(); }
+
+    // Whether the budget has been exhausted or the run cancelled
+    bool expired() const { return _control.cancel.cancelled() || _deadline.expired(); }
+
+    bool stop(std::size_t iterations) const { return iterations >= _control.iterations || expired(); }
+
+    bool reporting() const { return static_cast<bool>(_control.progress); }
+
+    // Reports the progress, unless less than an interval has passed since the last report
+    void report(double cost, double penalty, double temperature, std::size_t iterations, bool force = false)
+    {
+        if (!_control.progress)
+            return;
+
+        const double now = _deadline.elapsed();
+
+        if (!force && now - _reported < _control.interval)
+            return;
+
+        const double rate = now > _reported ? static_cast<double>(iterations - _iterations) / (now - _reported) : 0.0;
+
+        _control.progress(Progress{ cost, penalty, temperature, iterations, rate, now });
+
+        _reported = now; _iterations = iterations;
+    }
+};
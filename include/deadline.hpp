@@ -0,0 +1,34 @@
+
+#pragma once
+
+#include <chrono>       // std::chrono
+#include <limits>       // std::numeric_limits
+#include <cmath>        // std::isfinite
+
+// A wall clock budget measured from the moment of construction
+class Deadline
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point _start;
+
+    double _seconds;
+
+public:
+
+    Deadline(double _seconds = std::numeric_limits<double>::infinity())
+    :
+    _start(Clock::now()), _seconds(_seconds)
+    {
+    }
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(Clock::now() - _start).count();
+    }
+
+    bool expired() const
+    {
+        return std::isfinite(_seconds) && elapsed() >= _seconds;
+    }
+};
@@ -0,0 +1,37 @@
+
+#pragma once
+
+#include "localsearch.hpp"
+#include "vector2.hpp"
+#include <vector>       // std::vector
+#include <cstddef>      // std::size_t
+
+namespace Decomposition
+{
+    enum class Partition
+    {
+        Grid,   // Square cells over the bounding box
+        KMeans  // Lloyd's iterations starting from centroids spread along a Hilbert curve
+    };
+
+    // Large instances are partitioned into clusters of stops lying close to one another,
+    // every cluster is solved on its own, concurrently with the rest, and the resulting
+    // cycles are stitched together in the order of their centroids along a Hilbert curve.
+    // Finally, the seams are repaired by a pass of local search over the whole tour
+    struct Options
+    {
+        Partition partition = Partition::KMeans;
+
+        std::size_t cluster = 1000UL;       // Average number of stops per cluster
+
+        std::size_t iterations = 5UL;       // Lloyd's iterations
+
+        std::size_t threads = 1UL;          // Worker threads
+
+        LocalSearch::Options search;        // Options of the cluster solves and the repair
+    };
+
+    // The indices of the points making up every cluster, both the clusters and their members
+    // ordered along a Hilbert curve. Empty clusters are omitted
+    std::vector<std::vector<std::size_t>> partition(const std::vector<Vector2>&, const Options&);
+}
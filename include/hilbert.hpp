@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include "vector2.hpp"
+#include <vector>       // std::vector
+#include <cstdint>      // std::uint64_t
+
+// Maps the points of a bounding box onto the distance along a Hilbert curve
+// filling it, so that sorting by the distance keeps nearby points together
+class HilbertCurve
+{
+    static constexpr unsigned order = 20U;
+
+    double _x, _y, _scale;
+
+public:
+
+    // The bounding box of the specified points
+    HilbertCurve(const std::vector<Vector2>&);
+
+    std::uint64_t operator()(const Vector2&) const;
+};
@@ -0,0 +1,135 @@
+
+#pragma once
+
+#include <chrono>       // std::chrono
+#include <vector>       // std::vector
+#include <ostream>      // std::ostream
+#include <cstddef>      // std::size_t
+
+// Optional counters and timers of the hot paths (the annealing loops, opt2 and the
+// construction heuristics), compiled in with -D __INSTRUMENT__ only. Otherwise,
+// whatever is wrapped in INSTRUMENT(...) vanishes and nothing is measured.
+// Every solver appends rows to a process wide trace, e.g. one per chain and temperature,
+// which may be written as CSV by Instrument::dump
+#ifdef __INSTRUMENT__
+
+#define INSTRUMENT(...) __VA_ARGS__
+
+namespace Instrument
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Iterations per row of the solvers lacking a temperature schedule of their own
+    const std::size_t interval = 10000UL;
+
+    // What a solver did over an interval; the timers are in seconds
+    struct Sample
+    {
+        std::size_t iterations = 0UL, accepted = 0UL, improved = 0UL, allocations = 0UL;
+
+        double generate = 0.0;      // Generating neighbours
+        double evaluate = 0.0;      // Evaluating them (move based solvers generate and evaluate at once)
+        double apply    = 0.0;      // Applying the accepted ones
+        double elapsed  = 0.0;
+    };
+
+    // A row of the trace. The step is the index of the temperature in the case of
+    // compressed annealing and the number of iterations so far in that of simulated annealing
+    struct Record
+    {
+        const char * solver;
+
+        std::size_t chain, step;
+
+        double temperature, pressure, cost, penalty;
+
+        Sample sample;
+    };
+
+    // The number of allocations by the calling thread so far
+    std::size_t allocations();
+
+    // Thread safe
+    void record(const Record&);
+
+    std::vector<Record> trace();
+
+    void clear();
+
+    // Writes the trace as CSV, one row per record
+    void dump(std::ostream&);
+
+    // Accumulates the sample of a single thread between begin and end
+    class Probe
+    {
+        Sample _sample;
+
+        Clock::time_point _start, _lap;
+
+        std::size_t _allocations;
+
+    public:
+
+        std::size_t chain = 0UL;
+
+        Probe() : _sample(), _start(Clock::now()), _lap(_start), _allocations(allocations()) {}
+
+        void begin()
+        {
+            _start = _lap = Clock::now(); _allocations = allocations();
+        }
+
+        // Charges the time since the last lap to the specified timer
+        void lap(double Sample::* timer)
+        {
+            const Clock::time_point now = Clock::now();
+
+            _sample.*timer += std::chrono::duration<double>(now - _lap).count(); _lap = now;
+        }
+
+        void iterated() { _sample.iterations++; }
+        void accepted() { _sample.accepted++; }
+        void improved() { _sample.improved++; }
+
+        void end()
+        {
+            _sample.elapsed += std::chrono::duration<double>(Clock::now() - _start).count();
+
+            _sample.allocations += allocations() - _allocations;
+        }
+
+        // Appends the sample to the trace and starts anew
+        void record(const char * solver, std::size_t step, double temperature, double pressure, double cost, double penalty)
+        {
+            Instrument::record(Record{ solver, chain, step, temperature, pressure, cost, penalty, _sample });
+
+            _sample = Sample();
+        }
+    };
+
+    // Records the duration and the allocations of a scope
+    class Scope
+    {
+        Probe _probe;
+
+        const char * _solver;
+
+    public:
+
+        explicit Scope(const char * _solver) : _probe(), _solver(_solver) {}
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope()
+        {
+            _probe.end(); _probe.record(_solver, 0UL, 0.0, 0.0, 0.0, 0.0);
+        }
+    };
+}
+
+#else
+
+#define INSTRUMENT(...)
+
+#endif
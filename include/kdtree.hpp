@@ -0,0 +1,96 @@
+
+#pragma once
+
+#include "vector2.hpp"
+#include "simd.hpp"
+#include <vector>       // std::vector
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint8_t
+
+// A static 2-d tree over a set of points identified by their index,
+// supporting k-nearest queries and the removal of points.
+// The tree is implicit; the subtree spanning [lo, hi) of the internal order
+// is rooted at (lo + hi) / 2 and split along the axis of widest spread,
+// unless it holds no more than bucket points, in which case it is a leaf
+// scanned at once by the Simd kernels. Points added to an existing tree
+// follow it in the internal order, where they are scanned one by one
+class KDTree
+{
+    static constexpr std::size_t bucket = 16UL;
+
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    // The coordinates in the internal order
+    Points _points;
+
+    // The id at every position of the internal order (none, should its point have been left out)
+    // and the position of every id
+    std::vector<std::size_t> _ids, _position;
+
+    // The positions spanned by the tree and the number of points not yet removed past them
+    std::size_t _tree, _tail;
+
+    std::vector<bool> _vertical;
+
+    // The number of points not yet removed in the subtree rooted at each position
+    // (or, in the case of a leaf, at its first position)
+    std::vector<std::size_t> _alive;
+
+    std::vector<bool> _removed;
+
+    // Whether the point at each position of the internal order has been removed
+    std::vector<std::uint8_t> _masked;
+
+    void _build(std::size_t, std::size_t, const std::vector<Vector2>&);
+
+    void _erase(std::size_t);
+
+    template <typename Heap>
+    void _nearest(std::size_t, std::size_t, double, double, std::size_t, std::size_t, Heap&) const;
+
+public:
+
+    KDTree();
+    KDTree(const std::vector<Vector2>&);
+
+    // The specified points of the base, renumbered in that order, followed by the additional points.
+    // The points left out are removed and the additional ones added past the tree, unless more than
+    // 4 buckets of points would lie past it or more points be left out than kept, in which case
+    // the tree is built anew. Either way, the removed points of the base remain removed
+    KDTree(const KDTree&, const std::vector<std::size_t>&, const std::vector<Vector2>&);
+
+    std::size_t size() const { return _position.size(); }
+
+    // The root of a tree of no more than bucket points is a leaf, whose count lies at its first position
+    std::size_t alive() const { return (_tree == 0UL ? 0UL : _alive[_tree <= bucket ? 0UL : _tree / 2UL]) + _tail; }
+
+    bool removed(std::size_t id) const { return _removed[id]; }
+
+    Vector2 point(std::size_t id) const { return Vector2(_points.x(_position[id]), _points.y(_position[id])); }
+
+    void remove(std::size_t);
+
+    // The ids of the k points nearest to the specified one, in ascending order of distance,
+    // skipping the removed points and, optionally, the excluded id
+    std::vector<std::size_t> nearest(const Vector2&, std::size_t, std::size_t = static_cast<std::size_t>(-1)) const;
+
+    // The id of the point nearest to the specified one, or size() if every point has been removed
+    std::size_t nearest(const Vector2&) const;
+};
+
+// Specialized for the types whose elements lie on the plane. Solvers rely on a KDTree
+// instead of pairwise scans over such elements only if told, on construction,
+// that the duration between any two of them grows with their euclidean distance
+template <typename T>
+struct Spatial
+{
+    static constexpr bool value = false;
+};
+
+template <>
+struct Spatial<Vector2>
+{
+    static constexpr bool value = true;
+
+    static const Vector2& position(const Vector2& v) { return v; }
+};
@@ -0,0 +1,100 @@
+
+#pragma once
+
+#include "neighbours.hpp"
+#include "moves.hpp"
+#include "control.hpp"
+#include <vector>       // std::vector
+#include <cstddef>      // std::size_t
+
+namespace LocalSearch
+{
+    enum class Strategy
+    {
+        First,  // Apply the first improving move found
+        Best    // Apply the best improving move of every node examined
+    };
+
+    // The limits inherited from Control bound the improving moves applied and
+    // the duration of a single search; the progress reports the length of the tour
+    // (or the cost and penalty of a route with timewindows)
+    struct Options : Control
+    {
+        Strategy strategy = Strategy::First;
+
+        std::size_t neighbours = 10UL;                                  // Candidate list length
+
+        std::size_t segment = 3UL;                                      // Maximum Or-opt segment length
+
+        std::size_t depth = 50UL;                                       // Maximum Lin-Kernighan move depth
+
+        std::size_t kicks = 0UL;                                        // Lin-Kernighan perturbations
+
+        std::vector<std::size_t> focus;                                 // The ids examined at first; every id if empty
+    };
+
+    // Returns the number of improving moves applied to the tour
+    // NOTICE:
+    // the gain of every move is evaluated in constant time,
+    // which assumes a symmetric distance
+    template <typename Tour, typename Distance>
+    std::size_t opt2(
+        Tour&,
+        const Distance&,
+        const Neighbours&,
+        const Options&
+    );
+
+    // Moves segments of up to options.segment stops, either as they are or reversed,
+    // next to one of the candidates of their first or last stop
+    template <typename Tour, typename Distance>
+    std::size_t oropt(
+        Tour&,
+        const Distance&,
+        const Neighbours&,
+        const Options&
+    );
+
+    // Exchanges two consecutive segments of any length, i.e. a -> b..c -> d..e -> f
+    // becomes a -> d..e -> b..c -> f, which is the only pure 3-opt move keeping
+    // the orientation of every segment
+    template <typename Tour, typename Distance>
+    std::size_t or3opt(
+        Tour&,
+        const Distance&,
+        const Neighbours&,
+        const Options&
+    );
+
+    // Lin-Kernighan; sequential k-opt moves built out of successive 2-opt flips
+    // as long as the partial gain remains positive, with breadth (5, 3, 1) backtracking.
+    // Once at a local optimum, the tour is perturbed by up to options.kicks
+    // segment exchanges (double bridges), each of which is kept only if the
+    // search following it results in a shorter tour
+    template <typename Tour, typename Distance>
+    std::size_t linkernighan(
+        Tour&,
+        const Distance&,
+        const Neighbours&,
+        const Options&
+    );
+
+    // The same moves performed on a route with timewindows; a move is applied
+    // only if it does not increase the penalty and either decreases the penalty
+    // or the cost, hence feasible routes remain feasible
+    template <typename Distance>
+    std::size_t oropt(
+        WindowedMoves<Distance>&,
+        const Neighbours&,
+        const Options&
+    );
+
+    template <typename Distance>
+    std::size_t or3opt(
+        WindowedMoves<Distance>&,
+        const Neighbours&,
+        const Options&
+    );
+}
+
+#include "localsearch.ipp"
@@ -0,0 +1,982 @@
+
+#pragma once
+
+#include "control.hpp"
+#include "instrument.hpp"
+#include "tour.hpp"
+#include "random.hpp"
+#include <vector>       // std::vector
+#include <deque>        // std::deque
+#include <utility>      // std::pair
+#include <cmath>        // std::fabs
+#include <algorithm>    // std::reverse, std::partial_sort, std::max, std::min
+#include <functional>   // std::function
+
+namespace LocalSearch
+{
+    // The nodes whose don't-look bit is off, examined in FIFO order
+    class DontLookBits
+    {
+        std::deque<std::size_t> _active;
+
+        std::vector<bool> _queued;
+
+    public:
+
+        explicit DontLookBits(std::size_t n)
+        :
+        _active(), _queued(n, false)
+        {
+        }
+
+        bool empty() const { return _active.empty(); }
+
+        void activate(std::size_t id)
+        {
+            if (id < _queued.size() && !_queued[id])
+            {
+                _queued[id] = true; _active.push_back(id);
+            }
+        }
+
+        std::size_t pop()
+        {
+            const std::size_t id = _active.front(); _active.pop_front(); _queued[id] = false;
+
+            return id;
+        }
+
+        // Activates the specified ids and returns whether there were any
+        bool focus(const std::vector<std::size_t>& ids)
+        {
+            for (const std::size_t id : ids)
+                activate(id);
+
+            return !ids.empty();
+        }
+    };
+
+    // Whether the (cost, penalty) delta is lexicographically better than the reference,
+    // the penalty taking precedence over the cost
+    inline bool improves
+    (
+        const std::pair<double, double>& delta,
+        const std::pair<double, double>& reference,
+        double epsilon
+    )
+    {
+        if (delta.second < reference.second - epsilon)
+            return true;
+
+        return delta.second <= reference.second + epsilon && delta.first < reference.first - epsilon;
+    }
+
+    // The length of the tour with respect to the distance
+    template <typename Tour, typename Distance>
+    double length(const Tour& tour, const Distance& distance)
+    {
+        double total = 0.0;
+
+        for (std::size_t i = 0UL, id = 0UL; i < tour.size(); i++)
+        {
+            const std::size_t next = tour.next(id);
+
+            total += distance(id, next); id = next;
+        }
+
+        return total;
+    }
+}
+
+// 2-opt using neighbour lists and don't-look bits
+// @ Bentley, J. L. (1992). Fast algorithms for geometric traveling salesman problems
+template <typename Tour, typename Distance>
+std::size_t LocalSearch::opt2(
+    Tour& tour,
+    const Distance& distance,
+    const Neighbours& neighbours,
+    const Options& options
+)
+{
+    const std::size_t n = tour.size();
+
+    if (n < 4UL)
+        return 0UL;
+
+    Monitor monitor(options);
+
+    DontLookBits active(n);
+    if (!active.focus(options.focus))
+        for (std::size_t id = 0UL; id < n; id++)
+            active.activate(id);
+
+    // Only kept track of for the sake of the progress reports
+    double cost = monitor.reporting() ? length(tour, distance) : 0.0;
+
+    INSTRUMENT(Instrument::Probe probe;)
+
+    std::size_t moves = 0UL, examined = 0UL;
+    while (!active.empty() && moves < options.iterations)
+    {
+        if ((++examined & 0xFFUL) == 0UL)
+        {
+            if (monitor.expired())
+                break;
+
+            monitor.report(cost, 0.0, 0.0, moves);
+        }
+
+        const std::size_t a = active.pop();
+
+        double bdelta = 0.0; std::size_t bc = n; bool bsucc = true;
+
+        for (const bool succ : { true, false })
+        {
+            const std::size_t b = succ ? tour.next(a) : tour.prev(a);
+
+            const double dab = distance(a, b);
+
+            for (std::size_t r = 0UL; r < neighbours.k(); r++)
+            {
+                const std::size_t c = neighbours.id(a, r);
+
+                const double dac = neighbours.distance(a, r);
+
+                // Neighbours are sorted, hence no further gain is possible
+                if (dac >= dab)
+                    break;
+
+                const std::size_t d = succ ? tour.next(c) : tour.prev(c);
+
+                if (c == b || d == a)
+                    continue;
+
+                const double dcd = distance(c, d);
+                const double delta = dac + distance(b, d) - dab - dcd;
+
+                INSTRUMENT(probe.iterated();)
+
+                if (delta < bdelta - 1e-12 * (dab + dcd))
+                {
+                    bdelta = delta; bc = c; bsucc = succ;
+
+                    if (options.strategy == Strategy::First)
+                        break;
+                }
+            }
+
+            if (bc != n && options.strategy == Strategy::First)
+                break;
+        }
+
+        INSTRUMENT(probe.lap(&Instrument::Sample::evaluate);)
+
+        if (bc == n)
+            continue;
+
+        // a -> b ... c -> d  becomes  a -> c ... b -> d
+        const std::size_t b = bsucc ? tour.next(a)  : tour.prev(a);
+        const std::size_t d = bsucc ? tour.next(bc) : tour.prev(bc);
+
+        if (bsucc)
+            tour.reverse(b, bc);
+        else
+            tour.reverse(a, d);
+
+        active.activate(a); active.activate(b); active.activate(bc); active.activate(d);
+
+        cost += bdelta; moves++;
+
+        INSTRUMENT(probe.lap(&Instrument::Sample::apply); probe.accepted(); probe.improved();)
+    }
+
+    INSTRUMENT(probe.end(); probe.record("opt2", examined, 0.0, 0.0, length(tour, distance), 0.0);)
+
+    monitor.report(cost, 0.0, 0.0, moves, true);
+
+    return moves;
+}
+
+// Or-opt using neighbour lists and don't-look bits
+// @ Or, I. (1976). Traveling salesman-type combinatorial problems and their relation
+//   to the logistics of regional blood banking
+template <typename Tour, typename Distance>
+std::size_t LocalSearch::oropt(
+    Tour& tour,
+    const Distance& distance,
+    const Neighbours& neighbours,
+    const Options& options
+)
+{
+    const std::size_t n = tour.size();
+
+    if (n < 4UL)
+        return 0UL;
+
+    Monitor monitor(options);
+
+    DontLookBits active(n);
+    if (!active.focus(options.focus))
+        for (std::size_t id = 0UL; id < n; id++)
+            active.activate(id);
+
+    // Only kept track of for the sake of the progress reports
+    double cost = monitor.reporting() ? length(tour, distance) : 0.0;
+
+    std::vector<std::size_t> segment;
+
+    auto contains = [&segment](std::size_t id)
+    {
+        for (const std::size_t s : segment)
+            if (s == id)
+                return true;
+
+        return false;
+    };
+
+    std::size_t moves = 0UL, examined = 0UL;
+    while (!active.empty() && moves < options.iterations)
+    {
+        if ((++examined & 0xFFUL) == 0UL)
+        {
+            if (monitor.expired())
+                break;
+
+            monitor.report(cost, 0.0, 0.0, moves);
+        }
+
+        const std::size_t s = active.pop();
+
+        // The best move found; the segment starting at s, travelling in the bsucc direction,
+        // is placed in between bu and its successor (in the same direction)
+        double bdelta = 0.0; std::size_t blength = 0UL, bu = n; bool bsucc = true, breversed = false;
+
+        for (const bool succ : { true, false })
+        {
+            auto step = [&tour, succ](std::size_t id) { return succ ? tour.next(id) : tour.prev(id); };
+            auto back = [&tour, succ](std::size_t id) { return succ ? tour.prev(id) : tour.next(id); };
+
+            const std::size_t p = back(s);
+
+            segment.assign(1UL, s);
+
+            for (std::size_t length = 1UL; length <= options.segment && length + 3UL <= n; length++)
+            {
+                if (bu != n && options.strategy == Strategy::First)
+                    break;
+
+                if (length > 1UL)
+                    segment.push_back(step(segment.back()));
+
+                const std::size_t e = segment.back(), q = step(e);
+
+                // The gain of closing the gap the segment leaves behind
+                const double removal = distance(p, s) + distance(e, q) - distance(p, q);
+
+                // The candidates of either end of the segment
+                for (std::size_t side = 0UL; side < (length == 1UL ? 1UL : 2UL); side++)
+                {
+                    const std::size_t end = side == 0UL ? s : e;
+
+                    for (std::size_t r = 0UL; r < neighbours.k(); r++)
+                    {
+                        const std::size_t c = neighbours.id(end, r);
+
+                        // Neighbours are sorted, hence no further gain is possible
+                        if (neighbours.distance(end, r) >= removal)
+                            break;
+
+                        if (contains(c))
+                            continue;
+
+                        // The segment is placed either after or before c with end next to c
+                        for (const bool after : { true, false })
+                        {
+                            const std::size_t u = after ? c : back(c), v = after ? step(c) : c;
+
+                            if (contains(u) || contains(v))
+                                continue;
+
+                            const bool reversed = length > 1UL && (after ? end == e : end == s);
+
+                            const std::size_t x = reversed ? e : s, y = reversed ? s : e;
+
+                            const double duv = distance(u, v);
+                            const double delta = distance(u, x) + distance(y, v) - duv - removal;
+
+                            if (delta < bdelta - 1e-12 * (removal + duv))
+                            {
+                                bdelta = delta; blength = length; bu = u; bsucc = succ; breversed = reversed;
+
+                                if (options.strategy == Strategy::First)
+                                    break;
+                            }
+                        }
+
+                        if (bu != n && options.strategy == Strategy::First)
+                            break;
+                    }
+
+                    if (bu != n && options.strategy == Strategy::First)
+                        break;
+                }
+            }
+
+            if (bu != n && options.strategy == Strategy::First)
+                break;
+        }
+
+        if (bu == n)
+            continue;
+
+        auto step = [&tour, bsucc](std::size_t id) { return bsucc ? tour.next(id) : tour.prev(id); };
+
+        std::size_t e = s;
+        for (std::size_t l = 1UL; l < blength; l++)
+            e = step(e);
+
+        const std::size_t p = bsucc ? tour.prev(s) : tour.next(s), q = step(e), v = step(bu);
+
+        // p -> s..e -> q ... u -> v  becomes  p -> q ... u -> e..s -> v
+        reversePath(tour, s, bu, p);
+        reversePath(tour, bu, q, p);
+
+        // and, unless meant to be reversed, u -> s..e -> v
+        if (!breversed)
+            reversePath(tour, e, s, p);
+
+        active.activate(p); active.activate(q); active.activate(s);
+        active.activate(e); active.activate(bu); active.activate(v);
+
+        cost += bdelta; moves++;
+    }
+
+    monitor.report(cost, 0.0, 0.0, moves, true);
+
+    return moves;
+}
+
+template <typename Tour, typename Distance>
+std::size_t LocalSearch::or3opt(
+    Tour& tour,
+    const Distance& distance,
+    const Neighbours& neighbours,
+    const Options& options
+)
+{
+    const std::size_t n = tour.size();
+
+    if (n < 5UL)
+        return 0UL;
+
+    Monitor monitor(options);
+
+    DontLookBits active(n);
+    if (!active.focus(options.focus))
+        for (std::size_t id = 0UL; id < n; id++)
+            active.activate(id);
+
+    // Only kept track of for the sake of the progress reports
+    double cost = monitor.reporting() ? length(tour, distance) : 0.0;
+
+    std::size_t moves = 0UL, examined = 0UL;
+    while (!active.empty() && moves < options.iterations)
+    {
+        if ((++examined & 0xFFUL) == 0UL)
+        {
+            if (monitor.expired())
+                break;
+
+            monitor.report(cost, 0.0, 0.0, moves);
+        }
+
+        const std::size_t a = active.pop();
+
+        double bdelta = 0.0; std::size_t bd = n, be = n; bool bsucc = true;
+
+        for (const bool succ : { true, false })
+        {
+            auto step = [&tour, succ](std::size_t id) { return succ ? tour.next(id) : tour.prev(id); };
+            auto back = [&tour, succ](std::size_t id) { return succ ? tour.prev(id) : tour.next(id); };
+
+            // Whether id lies on the path travelling from b to e in the current direction
+            auto within = [&tour, succ](std::size_t b, std::size_t id, std::size_t e)
+            {
+                return succ ? tour.between(b, id, e) : tour.between(e, id, b);
+            };
+
+            const std::size_t b = step(a);
+
+            const double dab = distance(a, b);
+
+            for (std::size_t r = 0UL; r < neighbours.k(); r++)
+            {
+                const std::size_t e = neighbours.id(b, r);
+
+                // The partial gain of replacing a -> b by e -> b
+                const double g1 = dab - neighbours.distance(b, r);
+
+                if (g1 <= 0.0)
+                    break;
+
+                const std::size_t f = step(e);
+
+                if (e == a || f == a)
+                    continue;
+
+                const double def = distance(e, f), g2 = g1 + def;
+
+                for (std::size_t t = 0UL; t < neighbours.k(); t++)
+                {
+                    const std::size_t d = neighbours.id(a, t);
+
+                    const double dad = neighbours.distance(a, t);
+
+                    if (dad >= g2)
+                        break;
+
+                    if (d == b || !within(b, d, e))
+                        continue;
+
+                    const std::size_t c = back(d);
+
+                    const double dcd = distance(c, d);
+                    const double delta = dad + distance(c, f) - dcd - g2;
+
+                    if (delta < bdelta - 1e-12 * (dab + dcd + def))
+                    {
+                        bdelta = delta; bd = d; be = e; bsucc = succ;
+
+                        if (options.strategy == Strategy::First)
+                            break;
+                    }
+                }
+
+                if (bd != n && options.strategy == Strategy::First)
+                    break;
+            }
+
+            if (bd != n && options.strategy == Strategy::First)
+                break;
+        }
+
+        if (bd == n)
+            continue;
+
+        const std::size_t b = bsucc ? tour.next(a)  : tour.prev(a);
+        const std::size_t c = bsucc ? tour.prev(bd) : tour.next(bd);
+        const std::size_t f = bsucc ? tour.next(be) : tour.prev(be);
+
+        // a -> b..c -> d..e -> f  becomes  a -> e..d -> c..b -> f
+        reversePath(tour, b, be, a);
+
+        // and then  a -> d..e -> b..c -> f
+        reversePath(tour, be, bd, a);
+        reversePath(tour, c, b, a);
+
+        active.activate(a); active.activate(b); active.activate(c);
+        active.activate(bd); active.activate(be); active.activate(f);
+
+        cost += bdelta; moves++;
+    }
+
+    monitor.report(cost, 0.0, 0.0, moves, true);
+
+    return moves;
+}
+
+// Lin-Kernighan using neighbour lists, don't-look bits and double bridge kicks
+// @ Lin, S., Kernighan, B. W. (1973). An effective heuristic algorithm for the traveling-salesman problem
+// @ Johnson, D. S., McGeoch, L. A. (1997). The traveling salesman problem: a case study in local optimization
+template <typename Tour, typename Distance>
+std::size_t LocalSearch::linkernighan(
+    Tour& tour,
+    const Distance& distance,
+    const Neighbours& neighbours,
+    const Options& options
+)
+{
+    const std::size_t n = tour.size();
+
+    if (n < 5UL)
+        return 0UL;
+
+    Monitor monitor(options);
+
+    DontLookBits active(n);
+    if (!active.focus(options.focus))
+        for (std::size_t id = 0UL; id < n; id++)
+            active.activate(id);
+
+    // Only kept track of for the sake of the progress reports
+    double cost = monitor.reporting() ? length(tour, distance) : 0.0;
+
+    // Every flip performed, as the arguments of reversePath, so that it may be undone
+    struct Flip { std::size_t u, v, x; };
+
+    std::vector<Flip> journal;
+
+    auto flip = [&tour, &journal](std::size_t u, std::size_t v, std::size_t x)
+    {
+        reversePath(tour, u, v, x); journal.push_back(Flip{ u, v, x });
+    };
+
+    auto undo = [&tour, &journal](std::size_t mark)
+    {
+        for (; journal.size() > mark; journal.pop_back())
+            reversePath(tour, journal.back().u, journal.back().v, journal.back().x);
+    };
+
+    // The edges added by the move under construction may not be removed
+    std::vector<std::pair<std::size_t, std::size_t>> added;
+
+    auto tabu = [&added](std::size_t a, std::size_t b)
+    {
+        for (const auto& edge : added)
+            if ((edge.first == a && edge.second == b) || (edge.first == b && edge.second == a))
+                return true;
+
+        return false;
+    };
+
+    const std::size_t breadth[] = { 5UL, 3UL };
+
+    struct Candidate { double lookahead, g1; std::size_t t3, t4; };
+
+    std::vector<std::vector<Candidate>> candidates(options.depth + 1UL);
+
+    double epsilon = 0.0;
+
+    // Extends the move t1 -> t2 (where the edge (t1, t2) has been removed and G is
+    // the partial gain) one flip at a time. If a closed tour better than the threshold
+    // is reached, the tour is left there and its gain returned; otherwise the tour is restored
+    std::function<double(std::size_t, std::size_t, std::size_t, double, double)> deepen =
+    [&](std::size_t level, std::size_t t1, std::size_t t2, double G, double threshold) -> double
+    {
+        if (level > options.depth)
+            return 0.0;
+
+        const bool succ = tour.next(t1) == t2;
+
+        std::vector<Candidate>& alternatives = candidates[level];
+
+        alternatives.clear();
+
+        for (std::size_t r = 0UL; r < neighbours.k(); r++)
+        {
+            const std::size_t t3 = neighbours.id(t2, r);
+
+            // The gain criterion
+            const double g1 = G - neighbours.distance(t2, r);
+
+            if (g1 <= epsilon)
+                break;
+
+            // t1 -> t2 ... t4 -> t3 becomes t1 -> t4 ... t2 -> t3
+            const std::size_t t4 = succ ? tour.prev(t3) : tour.next(t3);
+
+            if (t3 == t1 || t4 == t2 || tabu(t3, t4))
+                continue;
+
+            alternatives.push_back(Candidate{ g1 + distance(t3, t4), g1, t3, t4 });
+        }
+
+        const std::size_t width = level <= 2UL ? breadth[level - 1UL] : 1UL;
+
+        const std::size_t count = std::min(width, alternatives.size());
+
+        std::partial_sort
+        (
+            alternatives.begin(),
+            alternatives.begin() + count,
+            alternatives.end(),
+            [](const Candidate& A, const Candidate& B) { return A.lookahead > B.lookahead; }
+        );
+
+        for (std::size_t a = 0UL; a < count; a++)
+        {
+            const Candidate& candidate = alternatives[a];
+
+            const std::size_t mark = journal.size();
+
+            flip(t2, candidate.t4, t1); added.emplace_back(t2, candidate.t3);
+
+            const double closing = candidate.lookahead - distance(candidate.t4, t1);
+
+            const double target = std::max(threshold, closing);
+
+            const double deeper = deepen(level + 1UL, t1, candidate.t4, candidate.lookahead, target);
+
+            if (deeper > target + epsilon)
+                return deeper;
+
+            if (closing > threshold + epsilon)
+                return closing;
+
+            undo(mark); added.pop_back();
+        }
+
+        return 0.0;
+    };
+
+    // Returns the total gain of the improving moves applied, until no node remains active
+    std::size_t moves = 0UL, examined = 0UL;
+
+    auto improve = [&]()
+    {
+        double gain = 0.0;
+
+        while (!active.empty() && moves < options.iterations)
+        {
+            if ((++examined & 0xFFUL) == 0UL)
+            {
+                if (monitor.expired())
+                    break;
+
+                monitor.report(cost, 0.0, 0.0, moves);
+            }
+
+            const std::size_t t1 = active.pop();
+
+            for (const std::size_t t2 : { tour.next(t1), tour.prev(t1) })
+            {
+                const double G = distance(t1, t2);
+
+                epsilon = 1e-12 * G;
+
+                const std::size_t mark = journal.size();
+
+                added.clear();
+
+                const double g = deepen(1UL, t1, t2, G, 0.0);
+
+                if (g <= 0.0)
+                    continue;
+
+                gain += g; cost -= g; moves++;
+
+                active.activate(t1);
+
+                for (std::size_t f = mark; f < journal.size(); f++)
+                {
+                    active.activate(journal[f].u);   active.activate(journal[f].v);
+                    active.activate(tour.next(journal[f].u)); active.activate(tour.prev(journal[f].u));
+                    active.activate(tour.next(journal[f].v)); active.activate(tour.prev(journal[f].v));
+                }
+
+                break;
+            }
+        }
+
+        return gain;
+    };
+
+    improve(); journal.clear();
+
+    Random random;
+
+    for (std::size_t kick = 0UL; kick < options.kicks && moves < options.iterations && !monitor.expired(); kick++)
+    {
+        // A double bridge confined to nearby segments:
+        // a -> b..c -> d..e -> f  becomes  a -> d..e -> b..c -> f
+        const std::size_t span = std::max<std::size_t>(1UL, std::min<std::size_t>(50UL, (n - 2UL) / 2UL));
+
+        const std::size_t a = random.below(n), b = tour.next(a);
+
+        std::size_t c = b;
+        for (std::size_t l = random.below(span); l > 0UL; l--)
+            c = tour.next(c);
+
+        std::size_t e = tour.next(c);
+        const std::size_t d = e;
+        for (std::size_t l = random.below(span); l > 0UL; l--)
+            e = tour.next(e);
+
+        const std::size_t f = tour.next(e);
+
+        if (f == a || f == b)
+            continue;
+
+        double delta = distance(a, d) + distance(e, b) + distance(c, f)
+                     - distance(a, b) - distance(c, d) - distance(e, f);
+
+        flip(b, e, a); flip(e, d, a); flip(c, b, a);
+
+        for (const std::size_t id : { a, b, c, d, e, f })
+            active.activate(id);
+
+        const std::size_t before = moves;
+
+        const double previous = cost;
+
+        cost += delta; delta -= improve();
+
+        if (delta < -1e-12 * distance(a, b))
+            journal.clear();
+        else
+        {
+            undo(0UL); moves = before; cost = previous;
+
+            // Should the search have been cut short, the remaining nodes refer to the undone tour
+            while (!active.empty())
+                active.pop();
+        }
+    }
+
+    monitor.report(cost, 0.0, 0.0, moves, true);
+
+    return moves;
+}
+
+template <typename Distance>
+std::size_t LocalSearch::oropt(
+    WindowedMoves<Distance>& route,
+    const Neighbours& neighbours,
+    const Options& options
+)
+{
+    const std::vector<std::size_t>& ids = route.route();
+
+    const std::size_t n = ids.size() - 1UL, none = ids.size();
+
+    if (n < 2UL)
+        return 0UL;
+
+    Monitor monitor(options);
+
+    const double epsilon = 1e-9 * (1.0 + std::fabs(route.cost()));
+
+    // The position of every id amongst the ids of the route
+    std::vector<std::size_t> position(neighbours.size(), none);
+
+    auto reposition = [&position, &ids](std::size_t first, std::size_t last)
+    {
+        for (std::size_t p = first; p <= last; p++)
+            position[ids[p]] = p;
+    };
+
+    reposition(0UL, n);
+
+    DontLookBits active(neighbours.size());
+    if (!active.focus(options.focus))
+        for (std::size_t p = 1UL; p <= n; p++)
+            active.activate(ids[p]);
+
+    std::vector<std::size_t> segment, bsegment, candidate, best;
+
+    std::size_t moves = 0UL, examined = 0UL;
+    while (!active.empty() && moves < options.iterations)
+    {
+        // Every examination evaluates several moves in linear time, hence the more frequent checks
+        if ((++examined & 0xFUL) == 0UL)
+        {
+            if (monitor.expired())
+                break;
+
+            monitor.report(route.cost(), route.penalty(), 0.0, moves);
+        }
+
+        const std::size_t s = active.pop(), i = position[s];
+
+        if (i == 0UL || i == none)
+            continue;
+
+        std::pair<double, double> bdelta(0.0, 0.0); std::size_t blo = 0UL, bhi = 0UL;
+
+        auto found = [&blo, &options]() { return blo != 0UL && options.strategy == Strategy::First; };
+
+        for (std::size_t length = 1UL; length <= options.segment && i + length - 1UL <= n && !found(); length++)
+        {
+            segment.assign(ids.begin() + i, ids.begin() + i + length);
+
+            for (std::size_t side = 0UL; side < (length == 1UL ? 1UL : 2UL) && !found(); side++)
+            {
+                const std::size_t end = side == 0UL ? segment.front() : segment.back();
+
+                for (std::size_t r = 0UL; r < neighbours.k() && !found(); r++)
+                {
+                    const std::size_t pc = position[neighbours.id(end, r)];
+
+                    if (pc == none)
+                        continue;
+
+                    // The segment is placed right after the gap-th stop
+                    for (const std::size_t gap : { pc, pc == 0UL ? n : pc - 1UL })
+                    {
+                        if (found() || (gap + 1UL >= i && gap < i + length))
+                            continue;
+
+                        for (const bool reversed : { false, true })
+                        {
+                            if (reversed && length == 1UL)
+                                break;
+
+                            std::size_t lo, hi;
+
+                            candidate.clear();
+
+                            if (gap < i)
+                            {
+                                lo = gap + 1UL; hi = i + length - 1UL;
+
+                                candidate.insert(candidate.end(), segment.begin(), segment.end());
+                                candidate.insert(candidate.end(), ids.begin() + lo, ids.begin() + i);
+
+                                if (reversed)
+                                    std::reverse(candidate.begin(), candidate.begin() + length);
+                            }
+                            else
+                            {
+                                lo = i; hi = gap;
+
+                                candidate.insert(candidate.end(), ids.begin() + i + length, ids.begin() + hi + 1UL);
+                                candidate.insert(candidate.end(), segment.begin(), segment.end());
+
+                                if (reversed)
+                                    std::reverse(candidate.end() - length, candidate.end());
+                            }
+
+                            const std::pair<double, double> delta = route.evaluate(lo, hi, candidate);
+
+                            if (improves(delta, bdelta, epsilon))
+                            {
+                                bdelta = delta; blo = lo; bhi = hi; best = candidate; bsegment = segment;
+
+                                if (options.strategy == Strategy::First)
+                                    break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if (blo == 0UL)
+            continue;
+
+        active.activate(ids[blo - 1UL]);
+        active.activate(ids[bhi + 1UL == ids.size() ? 0UL : bhi + 1UL]);
+
+        route.commit(blo, bhi, best);
+
+        reposition(blo, bhi);
+
+        for (const std::size_t id : bsegment)
+            active.activate(id);
+
+        active.activate(ids[blo]); active.activate(ids[bhi]);
+
+        moves++;
+    }
+
+    monitor.report(route.cost(), route.penalty(), 0.0, moves, true);
+
+    return moves;
+}
+
+template <typename Distance>
+std::size_t LocalSearch::or3opt(
+    WindowedMoves<Distance>& route,
+    const Neighbours& neighbours,
+    const Options& options
+)
+{
+    const std::vector<std::size_t>& ids = route.route();
+
+    const std::size_t n = ids.size() - 1UL, none = ids.size();
+
+    if (n < 2UL)
+        return 0UL;
+
+    Monitor monitor(options);
+
+    const double epsilon = 1e-9 * (1.0 + std::fabs(route.cost()));
+
+    std::vector<std::size_t> position(neighbours.size(), none);
+
+    auto reposition = [&position, &ids](std::size_t first, std::size_t last)
+    {
+        for (std::size_t p = first; p <= last; p++)
+            position[ids[p]] = p;
+    };
+
+    reposition(0UL, n);
+
+    DontLookBits active(neighbours.size());
+    if (!active.focus(options.focus))
+        for (std::size_t p = 0UL; p <= n; p++)
+            active.activate(ids[p]);
+
+    std::vector<std::size_t> candidate, best;
+
+    std::size_t moves = 0UL, examined = 0UL;
+    while (!active.empty() && moves < options.iterations)
+    {
+        // Every examination evaluates several moves in linear time, hence the more frequent checks
+        if ((++examined & 0xFUL) == 0UL)
+        {
+            if (monitor.expired())
+                break;
+
+            monitor.report(route.cost(), route.penalty(), 0.0, moves);
+        }
+
+        const std::size_t a = active.pop();
+
+        if (position[a] == none || position[a] >= n)
+            continue;
+
+        // a -> b..c -> d..e -> f, where b lies at i, d at j and e at k
+        const std::size_t i = position[a] + 1UL, b = ids[i];
+
+        std::pair<double, double> bdelta(0.0, 0.0); std::size_t bhi = 0UL;
+
+        for (std::size_t r = 0UL; r < neighbours.k() && !(bhi && options.strategy == Strategy::First); r++)
+        {
+            const std::size_t j = position[neighbours.id(a, r)];
+
+            if (j == none || j <= i)
+                continue;
+
+            for (std::size_t t = 0UL; t < neighbours.k(); t++)
+            {
+                const std::size_t k = position[neighbours.id(b, t)];
+
+                if (k == none || k < j)
+                    continue;
+
+                candidate.assign(ids.begin() + j, ids.begin() + k + 1UL);
+                candidate.insert(candidate.end(), ids.begin() + i, ids.begin() + j);
+
+                const std::pair<double, double> delta = route.evaluate(i, k, candidate);
+
+                if (improves(delta, bdelta, epsilon))
+                {
+                    bdelta = delta; bhi = k; best = candidate;
+
+                    if (options.strategy == Strategy::First)
+                        break;
+                }
+            }
+        }
+
+        if (bhi == 0UL)
+            continue;
+
+        const std::size_t f = ids[bhi + 1UL == ids.size() ? 0UL : bhi + 1UL];
+
+        // The first and last stop of either segment
+        active.activate(a); active.activate(b); active.activate(f);
+        active.activate(best.front()); active.activate(best.back());
+
+        route.commit(i, bhi, best);
+
+        reposition(i, bhi);
+
+        moves++;
+    }
+
+    monitor.report(route.cost(), route.penalty(), 0.0, moves, true);
+
+    return moves;
+}
@@ -0,0 +1,159 @@
+
+#pragma once
+
+#include <functional>   // std::function
+#include <vector>       // std::vector
+#include <memory>       // std::unique_ptr, std::shared_ptr
+#include <atomic>       // std::atomic
+#include <mutex>        // std::mutex
+#include <cstddef>      // std::size_t
+
+// The pairwise durations between the ids [0, n).
+// If the full matrix fits in the memory budget, it is precomputed in a dense,
+// 64-byte aligned, row-major array. Otherwise, rows are filled lazily,
+// the first time they are accessed, until the budget is exhausted
+// and any remaining lookups are evaluated on the fly.
+// Alternatively, a dense matrix may be laid out elsewhere, e.g. in a memory mapped file,
+// or the matrix may be a view of another one through a remap of the ids
+class DistanceMatrix
+{
+public:
+
+    using Function = std::function<double(std::size_t, std::size_t)>;
+
+    static constexpr std::size_t budget = 256UL << 20;
+
+private:
+
+    std::size_t _size, _stride;
+
+    Function _function;
+
+    // Dense storage:
+    std::vector<double> _storage;
+
+    std::shared_ptr<const double> _shared;
+
+    const double * _data;
+
+    // Lazily filled rows:
+    std::unique_ptr<std::atomic<const double *>[]> _rows;
+
+    mutable std::vector<std::unique_ptr<double[]>> _cache;
+
+    mutable std::mutex _mutex;
+
+    std::size_t _capacity;
+
+    mutable std::atomic<bool> _exhausted;
+
+    // View of a root matrix, which is never a view itself:
+    std::shared_ptr<const DistanceMatrix> _base;
+
+    // The id in the root of every id; those past the size of the root have been appended to it
+    std::vector<std::size_t> _map;
+
+    // The durations from and to an appended id, indexed by the ids in the root up to itself
+    struct Appended
+    {
+        std::vector<double> from, to;
+    };
+
+    std::vector<std::shared_ptr<const Appended>> _appended;
+
+    const double * _fill(std::size_t) const;
+
+    // The duration between the ids in the root, at least one of which has been appended
+    double _lookup(std::size_t a, std::size_t b) const
+    {
+        const std::size_t m = _base->size();
+
+        return a >= b ? _appended[a - m]->from[b] : _appended[b - m]->to[a];
+    }
+
+    // Sets up either the dense storage, which is returned, or the lazily filled rows
+    double * _allocate(std::size_t);
+
+public:
+
+    // The number of doubles between the starts of successive rows of a dense matrix
+    static std::size_t stride(std::size_t size) { return (size + 7UL) & ~7UL; }
+
+    DistanceMatrix();
+
+    // Neither copies nor evaluates the rows of the specified dense matrix,
+    // whose first row is 64-byte aligned, but shares their ownership
+    DistanceMatrix(std::size_t, const std::shared_ptr<const double>&);
+
+    // The dense matrix is filled by invoking the specified callable directly,
+    // whereas lazily filled rows go through its type erased copy
+    template <typename Callable>
+    DistanceMatrix(std::size_t, const Callable&, std::size_t = budget);
+
+    // The first ids correspond to the specified ids of the base, whose durations are looked up
+    // in the base, which is shared rather than copied, and only those involving the rest
+    // are evaluated by the function. Once the ids left out of the root matrix or appended
+    // to it exceed a quarter of its ids, the durations are copied into a matrix of its own instead
+    DistanceMatrix(const std::shared_ptr<const DistanceMatrix>&, const std::vector<std::size_t>&, std::size_t, const Function&, std::size_t = budget);
+
+    DistanceMatrix(const DistanceMatrix&) = delete;
+    DistanceMatrix& operator=(const DistanceMatrix&) = delete;
+
+    std::size_t size() const { return _size; }
+
+    bool dense() const { return _data != nullptr; }
+
+    double operator()(std::size_t i, std::size_t j) const
+    {
+        if (_data)
+            return _data[i * _stride + j];
+
+        if (_base)
+        {
+            const std::size_t a = _map[i], b = _map[j];
+
+            return a < _base->size() && b < _base->size() ? (*_base)(a, b) : _lookup(a, b);
+        }
+
+        const double * row = _rows[i].load(std::memory_order_acquire);
+
+        if (!row && !_exhausted.load(std::memory_order_relaxed))
+            row = _fill(i);
+
+        return row ? row[j] : _function(i, j);
+    }
+
+    // Unlike operator(), never fills a row; suits lookups that are not repeated
+    double peek(std::size_t i, std::size_t j) const
+    {
+        if (_data)
+            return _data[i * _stride + j];
+
+        if (_base)
+        {
+            const std::size_t a = _map[i], b = _map[j];
+
+            return a < _base->size() && b < _base->size() ? _base->peek(a, b) : _lookup(a, b);
+        }
+
+        const double * row = _rows[i].load(std::memory_order_acquire);
+
+        return row ? row[j] : _function(i, j);
+    }
+
+    // The i-th row or nullptr if the budget has been exhausted or the matrix is a view
+    const double * row(std::size_t i) const
+    {
+        if (_data)
+            return _data + i * _stride;
+
+        if (_base)
+            return nullptr;
+
+        const double * row = _rows[i].load(std::memory_order_acquire);
+
+        return row || _exhausted.load(std::memory_order_relaxed) ? row : _fill(i);
+    }
+};
+
+#include "matrix.ipp"
@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include <cstddef>      // std::size_t
+
+template <typename Callable>
+DistanceMatrix::DistanceMatrix(std::size_t _size, const Callable& function, std::size_t budget)
+:
+_size(_size),
+_stride(stride(_size)),         // Every row starts at a 64-byte boundary
+_function(function),
+_storage(), _shared(), _data(nullptr),
+_rows(), _cache(), _mutex(), _capacity(0UL), _exhausted(false),
+_base(), _map(), _appended()
+{
+    double * data = _allocate(budget);
+
+    if (data)
+        for (std::size_t i = 0UL; i < _size; i++)
+            for (std::size_t j = 0UL; j < _size; j++)
+                data[i * _stride + j] = function(i, j);
+}
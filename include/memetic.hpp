@@ -0,0 +1,86 @@
+
+#pragma once
+
+#include "neighbours.hpp"
+#include "control.hpp"
+#include "random.hpp"
+#include <vector>       // std::vector
+#include <array>        // std::array
+#include <utility>      // std::pair
+#include <cstdint>      // std::uint64_t
+#include <cstddef>      // std::size_t
+
+// A memetic algorithm: a population of locally optimal routes is recombined by
+// edge assembly crossover, whose offspring are repaired by a local search
+// @ Nagata, Y., & Kobayashi, S. (2013). A powerful genetic algorithm using edge assembly crossover
+// for the traveling salesman problem
+namespace Memetic
+{
+    // Every generation, the individuals are paired at random and each one is replaced
+    // by the best of the offspring it bears with the next one, should that be better.
+    // The offspring of every pair are bred concurrently, each pair drawing from its own
+    // random stream, hence the result only depends on the seed, not the threads
+    struct Options
+    {
+        std::size_t population = 30UL;      // Individuals
+
+        std::size_t offspring = 10UL;       // Children per pair, one per AB-cycle tried
+
+        std::size_t generations = 1000UL;   // Generation limit
+
+        std::size_t stagnation = 30UL;      // Generations without a new best before stopping
+
+        std::size_t threads = 1UL;          // Worker threads
+
+        std::uint64_t seed = 1UL;
+    };
+
+    // The penalty and the cost of a route, compared lexicographically
+    using Fitness = std::pair<double, double>;
+
+    // The two ids every id is linked to in a tour, its predecessor followed by its successor
+    using Links = std::vector<std::array<std::size_t, 2>>;
+
+    // The edges of the first parent to be replaced by those of the second one,
+    // from their predecessor to their successor, should the tours be directed
+    struct Cycle
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> removed, added;
+    };
+
+    Links links(const std::vector<std::size_t>&);
+
+    // The edges of either parent missing from the other, decomposed into AB-cycles,
+    // i.e. cycles alternating between the edges of the first and the second parent.
+    // Unless directed, the edges may be traversed either way
+    std::vector<Cycle> cycles(const Links&, const Links&, bool, Random&);
+
+    // The route, starting from id 0, of links forming a single tour
+    std::vector<std::size_t> order(const Links&);
+
+    // Reorders the route by the specified number of double bridges, leaving its first id in place
+    void perturb(std::vector<std::size_t>&, std::size_t, Random&);
+
+    // Evolves a population grown out of the specified route, starting from id 0, and returns
+    // the fittest route found. Should the routes be directed, e.g. due to timewindows, every
+    // child traverses what it inherits in the direction of its parents, whereas otherwise
+    // the distance is expected to be symmetric. The fitness of a route is evaluated by a callable of the signature
+    // Fitness(const std::vector<std::size_t>&)
+    // and the local search to be carried out in place, examining the specified ids at first
+    // (every id, should there be none), by a callable of the signature
+    // void(std::vector<std::size_t>&, const std::vector<std::size_t>&)
+    // Both are invoked concurrently. Every generation counts as an iteration of the control
+    template <typename Distance, typename Evaluate, typename Improve>
+    std::vector<std::size_t> evolve(
+        const std::vector<std::size_t>&,
+        const Distance&,
+        const Neighbours&,
+        const Evaluate&,
+        const Improve&,
+        bool,
+        const Options& = Options(),
+        const Control& = Control()
+    );
+}
+
+#include "memetic.ipp"
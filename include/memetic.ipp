@@ -0,0 +1,308 @@
+
+#pragma once
+
+#include "threadpool.hpp"
+#include <vector>       // std::vector
+#include <utility>      // std::move, std::swap
+#include <limits>       // std::numeric_limits
+#include <algorithm>    // std::min_element, std::max
+
+namespace Memetic
+{
+    // Replaces the link of a to b by c; the first vacant one, should b be n
+    inline void relink(Links& links, std::size_t a, std::size_t b, std::size_t c)
+    {
+        if (links[a][0] == b)
+            links[a][0] = c;
+        else
+            links[a][1] = c;
+    }
+
+    // Links a to b, as its predecessor should the tour be directed, or else by their vacant links
+    inline void link(Links& links, std::size_t a, std::size_t b, bool directed)
+    {
+        if (directed)
+        {
+            links[a][1] = b; links[b][0] = a; return;
+        }
+
+        relink(links, a, links.size(), b); relink(links, b, links.size(), a);
+    }
+
+    // Labels every id by its subtour and returns the number of subtours
+    inline std::size_t label(const Links& links, std::vector<std::size_t>& labels)
+    {
+        const std::size_t n = links.size();
+
+        labels.assign(n, n);
+
+        std::size_t count = 0UL;
+
+        for (std::size_t start = 0UL; start < n; start++)
+        {
+            if (labels[start] != n)
+                continue;
+
+            std::size_t previous = links[start][0], current = start;
+
+            do
+            {
+                labels[current] = count;
+
+                const std::size_t next = links[current][0] == previous ? links[current][1] : links[current][0];
+
+                previous = current; current = next;
+            }
+            while (current != start);
+
+            count++;
+        }
+
+        return count;
+    }
+
+    // Merges the subtours into a tour, the smallest one at a time, by the cheapest 2-exchange
+    // with an edge of another subtour, adjacent to its neighbours or, should there be none, anywhere.
+    // Directed subtours are only reconnected from predecessor to successor
+    template <typename Distance>
+    void join(Links& links, const Distance& distance, const Neighbours& neighbours, bool directed, std::vector<std::size_t>& touched)
+    {
+        const std::size_t n = links.size();
+
+        std::vector<std::size_t> labels, sizes, members;
+
+        for (std::size_t count = label(links, labels); count > 1UL; count = label(links, labels))
+        {
+            sizes.assign(count, 0UL);
+
+            for (const std::size_t l : labels)
+                sizes[l]++;
+
+            const std::size_t smallest = static_cast<std::size_t>(std::min_element(sizes.begin(), sizes.end()) - sizes.begin());
+
+            members.clear();
+
+            for (std::size_t v = 0UL; v < n; v++)
+                if (labels[v] == smallest)
+                    members.push_back(v);
+
+            double best = std::numeric_limits<double>::infinity();
+
+            std::size_t bu = n, bu2 = n, bv = n, bv2 = n; bool crossed = false;
+
+            // Only the successors of directed subtours are considered
+            const std::size_t first = directed ? 1UL : 0UL;
+
+            // Replaces (u, u2) and (v, v2) by either (u, v) and (u2, v2) or (u, v2) and (v, u2)
+            auto consider = [&](std::size_t u, std::size_t u2, std::size_t v)
+            {
+                for (std::size_t s = first; s < 2UL; s++)
+                {
+                    const std::size_t v2 = links[v][s];
+
+                    const double removed = distance(u, u2) + distance(v, v2);
+
+                    const double straight = distance(u, v) + distance(u2, v2) - removed;
+                    const double crossing = distance(u, v2) + distance(v, u2) - removed;
+
+                    if (!directed && straight < best) { best = straight; bu = u; bu2 = u2; bv = v; bv2 = v2; crossed = false; }
+                    if (crossing < best) { best = crossing; bu = u; bu2 = u2; bv = v; bv2 = v2; crossed = true;  }
+                }
+            };
+
+            for (const std::size_t u : members)
+                for (std::size_t t = first; t < 2UL; t++)
+                    for (std::size_t r = 0UL; r < neighbours.k(); r++)
+                        if (labels[neighbours.id(u, r)] != smallest)
+                            consider(u, links[u][t], neighbours.id(u, r));
+
+            if (bu == n)
+                for (const std::size_t u : members)
+                    for (std::size_t t = first; t < 2UL; t++)
+                        for (std::size_t v = 0UL; v < n; v++)
+                            if (labels[v] != smallest)
+                                consider(u, links[u][t], v);
+
+            if (!directed)
+            {
+                relink(links, bu, bu2, n); relink(links, bu2, bu, n);
+                relink(links, bv, bv2, n); relink(links, bv2, bv, n);
+            }
+
+            link(links, bu, crossed ? bv2 : bv, directed); link(links, crossed ? bv : bv2, bu2, directed);
+
+            touched.insert(touched.end(), { bu, bu2, bv, bv2 });
+        }
+    }
+
+    // Breeds a child per AB-cycle of a random sample and keeps the fittest one, provided it is fitter than the
+    // specified fitness, which is updated accordingly. The child inherits the edges of the first parent,
+    // but for those of the cycle, which are replaced by the edges of the second one, its subtours merged
+    template <typename Distance, typename Evaluate, typename Improve>
+    bool breed(
+        const std::vector<std::size_t>& A,
+        const std::vector<std::size_t>& B,
+        const Distance& distance,
+        const Neighbours& neighbours,
+        const Evaluate& evaluate,
+        const Improve& improve,
+        bool directed,
+        std::size_t offspring,
+        Random& random,
+        std::vector<std::size_t>& child,
+        Fitness& fitness
+    )
+    {
+        const Links a = links(A);
+
+        std::vector<Cycle> cycles = Memetic::cycles(a, links(B), directed, random);
+
+        const std::size_t n = A.size();
+
+        bool bred = false;
+
+        for (std::size_t c = 0UL; c < cycles.size() && c < offspring; c++)
+        {
+            std::swap(cycles[c], cycles[c + random.below(cycles.size() - c)]);
+
+            Links current(a); std::vector<std::size_t> touched;
+
+            // Directed links are overwritten by the edges of the second parent instead
+            if (!directed)
+                for (const auto& edge : cycles[c].removed)
+                {
+                    relink(current, edge.first, edge.second, n); relink(current, edge.second, edge.first, n);
+                }
+
+            for (const auto& edge : cycles[c].added)
+            {
+                link(current, edge.first, edge.second, directed);
+
+                touched.push_back(edge.first); touched.push_back(edge.second);
+            }
+
+            join(current, distance, neighbours, directed, touched);
+
+            std::vector<std::size_t> route(order(current));
+
+            improve(route, touched);
+
+            const Fitness candidate = evaluate(route);
+
+            if (candidate < fitness)
+            {
+                fitness = candidate; child = std::move(route); bred = true;
+            }
+        }
+
+        return bred;
+    }
+}
+
+template <typename Distance, typename Evaluate, typename Improve>
+std::vector<std::size_t> Memetic::evolve(
+    const std::vector<std::size_t>& route,
+    const Distance& distance,
+    const Neighbours& neighbours,
+    const Evaluate& evaluate,
+    const Improve& improve,
+    bool directed,
+    const Options& options,
+    const Control& control
+)
+{
+    Monitor monitor(control);
+
+    const std::size_t n = route.size(), size = std::max<std::size_t>(2UL, options.population);
+
+    // Too few ids for a pair of parents to differ
+    if (n < 5UL)
+        return route;
+
+    ThreadPool pool(options.threads > 1UL ? options.threads : 0UL);
+
+    // The first individual is the route itself locally optimised and the rest perturbations of it,
+    // diverse enough for the local search not to restore the route.
+    // Every individual, and every pair of parents later on, draws from a random stream of its own
+    std::vector<std::vector<std::size_t>> population(size, route);
+
+    std::vector<Fitness> fitness(size);
+
+    pool.parallel(size, [&](std::size_t i)
+    {
+        Random random(options.seed, i);
+
+        if (i > 0UL)
+            Memetic::perturb(population[i], std::max<std::size_t>(1UL, n / 10UL), random);
+
+        improve(population[i], std::vector<std::size_t>());
+
+        fitness[i] = evaluate(population[i]);
+    });
+
+    std::size_t best = static_cast<std::size_t>(std::min_element(fitness.begin(), fitness.end()) - fitness.begin());
+
+    monitor.report(fitness[best].second, fitness[best].first, 0.0, 0UL, true);
+
+    Random random(options.seed, size);
+
+    std::vector<std::size_t> order(size);
+
+    for (std::size_t i = 0UL; i < size; i++)
+        order[i] = i;
+
+    std::vector<std::vector<std::size_t>> children(size);
+
+    std::vector<Fitness> scores(size);
+
+    std::vector<char> bred(size);
+
+    std::size_t generation = 0UL;
+
+    for (std::size_t idle = 0UL; generation < options.generations && idle < options.stagnation && !monitor.stop(generation); generation++)
+    {
+        for (std::size_t i = size - 1UL; i > 0UL; i--)
+            std::swap(order[i], order[random.below(i + 1UL)]);
+
+        // The parents are only read whilst breeding
+        pool.parallel(size, [&](std::size_t i)
+        {
+            Random stream(options.seed, size + 1UL + generation * size + i);
+
+            scores[i] = fitness[order[i]];
+
+            bred[i] = Memetic::breed(
+                population[order[i]], population[order[(i + 1UL) % size]],
+                distance, neighbours, evaluate, improve, directed, options.offspring, stream, children[i], scores[i]
+            );
+        });
+
+        for (std::size_t i = 0UL; i < size; i++)
+        {
+            if (bred[i])
+            {
+                population[order[i]].swap(children[i]);
+            }
+        }
+
+        // The fittest individual may have been replaced by a child of its own
+        const Fitness previous = fitness[best];
+
+        for (std::size_t i = 0UL; i < size; i++)
+            if (bred[i])
+                fitness[order[i]] = scores[i];
+
+        best = static_cast<std::size_t>(std::min_element(fitness.begin(), fitness.end()) - fitness.begin());
+
+        if (fitness[best] < previous)
+            idle = 0UL;
+        else
+            idle++;
+
+        monitor.report(fitness[best].second, fitness[best].first, 0.0, generation + 1UL);
+    }
+
+    monitor.report(fitness[best].second, fitness[best].first, 0.0, generation, true);
+
+    return population[best];
+}
@@ -0,0 +1,249 @@
+
+#pragma once
+
+#include "random.hpp"
+#include "neighbours.hpp"
+#include "tour.hpp"
+#include <vector>       // std::vector
+#include <utility>      // std::pair
+#include <cstddef>      // std::size_t
+
+// Random moves on a route, evaluated by their cost delta and applied in place,
+// in order to be used by the move based Annealing::simulated.
+// The route holds the ids of the stops in visiting order;
+// its first id is considered fixed (the depot) and the route returns to it.
+// If candidate lists are provided, half of the reversals and shifts proposed
+// connect a stop to one of its candidates instead of a random one.
+// NOTICE:
+// the cost delta of reversing a segment assumes a symmetric distance
+// and the distance (as well as the candidate lists) is expected to outlive the moves
+template <typename Distance>
+class Moves
+{
+public:
+
+    enum Kind
+    {
+        Swap    = 1 << 0,   // Exchange two stops
+        Reverse = 1 << 1,   // Reverse a segment (2-opt)
+        Shift   = 1 << 2,   // Move a segment of 1 to 3 stops, possibly reversed (Or-opt)
+        All     = Swap | Reverse | Shift
+    };
+
+private:
+
+    const Distance * _distance;
+
+    const Neighbours * _neighbours;
+
+    Random _random;
+
+    std::vector<std::size_t> _route, _best;
+
+    // The position of every id in the route
+    std::vector<std::size_t> _position;
+
+    double _cost, _bcost;
+
+    std::vector<Kind> _kinds;
+
+    // The last move proposed:
+    Kind _kind;
+
+    std::size_t _i, _j, _length;
+
+    bool _reversed;
+
+    double _delta;
+
+    std::size_t _at(std::size_t p) const { return _route[p == _route.size() ? 0UL : p]; }
+
+    // A random candidate of the specified id
+    std::size_t _candidate(std::size_t id) { return _neighbours->id(id, _random.below(_neighbours->k())); }
+
+    bool _guided() { return _neighbours && _neighbours->k() > 0UL && _random.below(2UL); }
+
+    void _reposition(std::size_t, std::size_t);
+
+    double _proposeSwap();
+    double _proposeReverse();
+    double _proposeShift();
+
+public:
+
+    Moves(const Distance&, const std::vector<std::size_t>&, double, int = All, const Neighbours * = nullptr);
+
+    double cost() const { return _cost; }
+
+    const std::vector<std::size_t>& route() const { return _route; }
+
+    Random& random() { return _random; }
+
+    double propose();
+    void apply();
+
+    void save();
+    void restore();
+};
+
+// Random 2-opt reversals and Or-opt shifts performed on a Tour (e.g. a TwoLevelTour)
+// in order to be used by the move based Annealing::simulated on large instances,
+// where the O(n) reversals of Moves would dominate. No id is fixed, as the tour
+// is a cycle, and the route is only extracted, starting from id 0, upon request.
+// NOTICE:
+// the cost delta of reversing a segment assumes a symmetric distance
+// and the distance (as well as the candidate lists) is expected to outlive the moves
+template <typename Tour, typename Distance>
+class TourMoves
+{
+public:
+
+    enum Kind
+    {
+        Reverse = 1 << 0,   // Reverse a segment (2-opt)
+        Shift   = 1 << 1,   // Move a segment of 1 to 3 stops, possibly reversed (Or-opt)
+        All     = Reverse | Shift
+    };
+
+private:
+
+    const Distance * _distance;
+
+    const Neighbours * _neighbours;
+
+    Random _random;
+
+    Tour _tour, _best;
+
+    double _cost, _bcost;
+
+    std::vector<Kind> _kinds;
+
+    // The last move proposed; a -> b ... c -> d becomes a -> c ... b -> d, whereas
+    // p -> s..e -> q ... u -> v becomes p -> q ... u -> s..e -> v (or u -> e..s -> v)
+    Kind _kind;
+
+    bool _valid, _reversed;
+
+    std::size_t _b, _c, _p, _s, _e, _q, _u;
+
+    double _delta;
+
+    std::size_t _candidate(std::size_t id) { return _neighbours->id(id, _random.below(_neighbours->k())); }
+
+    bool _guided() { return _neighbours && _neighbours->k() > 0UL && _random.below(2UL); }
+
+    double _proposeReverse();
+    double _proposeShift();
+
+public:
+
+    TourMoves(const Distance&, const std::vector<std::size_t>&, double, int = All, const Neighbours * = nullptr);
+
+    double cost() const { return _cost; }
+
+    std::vector<std::size_t> route() const { return _tour.order(0UL); }
+
+    Random& random() { return _random; }
+
+    double propose();
+    void apply();
+
+    void save();
+    void restore();
+};
+
+// Random moves on a route with timewindows, in order to be used by the move based
+// Annealing::compressed. Every move is scored by its cost and penalty delta.
+// The arrival time at, and the penalty of, every position of the current route are kept,
+// together with suffix aggregates of the penalties and of the time slack, so that the
+// arrival times following the rearranged positions are shifted by a constant amount
+// and, in most cases, their penalty delta is evaluated in constant time.
+// Hence scoring a move costs O(1) plus the length of the rearranged segment,
+// whereas applying it costs O(n).
+// The distance, service times and timewindows are expected to outlive the moves
+template <typename Distance>
+class WindowedMoves
+{
+public:
+
+    using Timewindow = std::pair<double, double>;
+
+    enum Kind
+    {
+        Swap  = 1 << 0,     // Exchange two stops
+        Shift = 1 << 1,     // Move a stop to a different position
+        All   = Swap | Shift
+    };
+
+private:
+
+    const Distance * _distance;
+
+    const std::vector<double> * _service;
+
+    const std::vector<Timewindow> * _windows;
+
+    Random _random;
+
+    double _departureTime;
+
+    std::vector<std::size_t> _route, _best;
+
+    // Indexed by position, where position n + 1 is the return to the depot:
+    std::vector<double> _arrival, _penalties, _prefix;
+
+    // Suffix aggregates, i.e. over the positions following and including p:
+    std::vector<std::size_t> _late;     // The number of stops whose penalty grows with their arrival time
+    std::vector<double> _slack;         // The maximum delay not altering any penalty
+    std::vector<double> _room;          // The maximum advance only altering the penalty of the former
+
+    std::vector<Kind> _kinds;
+
+    // The last move proposed:
+    std::size_t _lo, _hi;
+
+    std::vector<std::size_t> _ids;
+
+    std::pair<double, double> _delta;
+
+    std::size_t _at(std::size_t p) const { return _route[p == _route.size() ? 0UL : p]; }
+
+    double _partialPenalty(std::size_t, double) const;
+
+    double _suffixDelta(std::size_t, double) const;
+
+    void _rebuild(std::size_t);
+
+public:
+
+    WindowedMoves
+    (
+        const Distance&,
+        const std::vector<double>&,
+        const std::vector<Timewindow>&,
+        double,
+        const std::vector<std::size_t>&,
+        int = All
+    );
+
+    double cost() const { return _arrival.back() - _departureTime; }
+    double penalty() const { return _prefix.back(); }
+
+    const std::vector<std::size_t>& route() const { return _route; }
+
+    Random& random() { return _random; }
+
+    // The cost and penalty delta of replacing the stops
+    // at the positions [lo, hi] by the specified ones
+    std::pair<double, double> evaluate(std::size_t, std::size_t, const std::vector<std::size_t>&) const;
+    void commit(std::size_t, std::size_t, const std::vector<std::size_t>&);
+
+    std::pair<double, double> propose();
+    void apply();
+
+    void save();
+    void restore();
+};
+
+#include "moves.ipp"
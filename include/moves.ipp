@@ -0,0 +1,578 @@
+
+#pragma once
+
+#include <vector>       // std::vector
+#include <algorithm>    // std::swap, std::reverse, std::rotate
+#include <limits>       // std::numeric_limits
+#include <cassert>      // assert
+
+template <typename Distance>
+Moves<Distance>::Moves
+(
+    const Distance& _distance,
+    const std::vector<std::size_t>& _route,
+    double _cost,
+    int kinds,
+    const Neighbours * _neighbours
+)
+:
+_distance(&_distance),
+_neighbours(_neighbours),
+_random(),
+_route(_route),
+_best(_route),
+_position(_route.empty() ? 0UL : *std::max_element(_route.begin(), _route.end()) + 1UL),
+_cost(_cost),
+_bcost(_cost),
+_kinds(),
+_kind(Swap),
+_i(0UL), _j(0UL), _length(0UL),
+_reversed(false),
+_delta(0.0)
+{
+    for (const Kind kind : { Swap, Reverse, Shift })
+        if (kinds & kind)
+            _kinds.push_back(kind);
+
+    _reposition(0UL, this->_route.size());
+}
+
+template <typename Distance>
+void Moves<Distance>::_reposition(std::size_t first, std::size_t last)
+{
+    for (std::size_t p = first; p < last; p++)
+        _position[_route[p]] = p;
+}
+
+template <typename Distance>
+double Moves<Distance>::_proposeSwap()
+{
+    const std::size_t n = _route.size() - 1UL;
+
+    _i = 1UL + _random.below(n);
+    _j = 1UL + _random.below(n - 1UL);
+
+    if (_j >= _i)
+        _j++;
+    else
+        std::swap(_i, _j);
+
+    const std::size_t a = _route[_i - 1UL], A = _route[_i], b = _at(_i + 1UL);
+    const std::size_t c = _route[_j - 1UL], B = _route[_j], d = _at(_j + 1UL);
+
+    if (_j == _i + 1UL)
+        return
+        (*_distance)(a, B) + (*_distance)(B, A) + (*_distance)(A, d)
+        - (*_distance)(a, A) - (*_distance)(A, B) - (*_distance)(B, d);
+
+    return
+    (*_distance)(a, B) + (*_distance)(B, b) + (*_distance)(c, A) + (*_distance)(A, d)
+    - (*_distance)(a, A) - (*_distance)(A, b) - (*_distance)(c, B) - (*_distance)(B, d);
+}
+
+template <typename Distance>
+double Moves<Distance>::_proposeReverse()
+{
+    const std::size_t n = _route.size() - 1UL;
+
+    if (_guided())
+    {
+        // The edge between a random stop and one of its candidates is introduced
+        const std::size_t pa = _random.below(n + 1UL);
+        const std::size_t pc = _position[_candidate(_route[pa])];
+
+        _i = std::min(pa, pc) + 1UL; _j = std::max(pa, pc);
+    }
+    else
+    {
+        _i = 1UL + _random.below(n);
+        _j = 1UL + _random.below(n - 1UL);
+
+        if (_j >= _i)
+            _j++;
+        else
+            std::swap(_i, _j);
+    }
+
+    const std::size_t a = _route[_i - 1UL], b = _route[_i];
+    const std::size_t c = _route[_j],       d = _at(_j + 1UL);
+
+    return (*_distance)(a, c) + (*_distance)(b, d) - (*_distance)(a, b) - (*_distance)(c, d);
+}
+
+template <typename Distance>
+double Moves<Distance>::_proposeShift()
+{
+    const std::size_t n = _route.size() - 1UL;
+
+    _length = 1UL + _random.below(std::min<std::size_t>(3UL, n - 1UL));
+
+    // The segment [_i, _i + _length) is moved in between _j and its successor
+    _i = 1UL + _random.below(n - _length + 1UL);
+
+    // The segment is preferably moved right after one of the candidates of its first stop
+    const std::size_t pc = _guided() ? _position[_candidate(_route[_i])] : _i;
+
+    if (pc + 1UL < _i || pc >= _i + _length)
+        _j = pc;
+    else
+    {
+        _j = _random.below(n - _length);
+
+        if (_j >= _i - 1UL)
+            _j += _length + 1UL;
+    }
+
+    _reversed = _length > 1UL && _random.below(2UL);
+
+    const std::size_t p = _route[_i - 1UL], s = _route[_i];
+    const std::size_t e = _route[_i + _length - 1UL], q = _at(_i + _length);
+    const std::size_t u = _route[_j], v = _at(_j + 1UL);
+
+    const double removed = (*_distance)(p, s) + (*_distance)(e, q) + (*_distance)(u, v);
+
+    const double added = (*_distance)(p, q) +
+    (
+        _reversed ?
+        (*_distance)(u, e) + (*_distance)(s, v) :
+        (*_distance)(u, s) + (*_distance)(e, v)
+    );
+
+    return added - removed;
+}
+
+template <typename Distance>
+double Moves<Distance>::propose()
+{
+    // There is nothing to rearrange
+    if (_route.size() < 3UL)
+        return _delta = 0.0;
+
+    _kind = _kinds[_random.below(_kinds.size())];
+
+    switch (_kind)
+    {
+        case Swap:
+            _delta = _proposeSwap();
+            break;
+
+        case Reverse:
+            _delta = _proposeReverse();
+            break;
+
+        default:
+            _delta = _proposeShift();
+            break;
+    }
+
+    return _delta;
+}
+
+template <typename Distance>
+void Moves<Distance>::apply()
+{
+    if (_route.size() < 3UL)
+        return;
+
+    switch (_kind)
+    {
+        case Swap:
+            std::swap(_route[_i], _route[_j]);
+
+            _position[_route[_i]] = _i; _position[_route[_j]] = _j;
+            break;
+
+        case Reverse:
+            std::reverse(_route.begin() + _i, _route.begin() + _j + 1UL);
+
+            _reposition(_i, _j + 1UL);
+            break;
+
+        default:
+        {
+            std::size_t first;
+
+            if (_j < _i)
+            {
+                std::rotate(_route.begin() + _j + 1UL, _route.begin() + _i, _route.begin() + _i + _length);
+
+                first = _j + 1UL;
+            }
+            else
+            {
+                std::rotate(_route.begin() + _i, _route.begin() + _i + _length, _route.begin() + _j + 1UL);
+
+                first = _j + 1UL - _length;
+            }
+
+            if (_reversed)
+                std::reverse(_route.begin() + first, _route.begin() + first + _length);
+
+            _reposition(std::min(_i, _j + 1UL), std::max(_i + _length, _j + 1UL));
+            break;
+        }
+    }
+
+    _cost += _delta;
+}
+
+template <typename Distance>
+void Moves<Distance>::save()
+{
+    _best = _route; _bcost = _cost;
+}
+
+template <typename Distance>
+void Moves<Distance>::restore()
+{
+    _route = _best; _cost = _bcost;
+
+    _reposition(0UL, _route.size());
+}
+
+// Class TourMoves:
+template <typename Tour, typename Distance>
+TourMoves<Tour, Distance>::TourMoves
+(
+    const Distance& _distance,
+    const std::vector<std::size_t>& route,
+    double _cost,
+    int kinds,
+    const Neighbours * _neighbours
+)
+:
+_distance(&_distance),
+_neighbours(_neighbours),
+_random(),
+_tour(route),
+_best(_tour),
+_cost(_cost),
+_bcost(_cost),
+_kinds(),
+_kind(Reverse),
+_valid(false),
+_reversed(false),
+_b(0UL), _c(0UL), _p(0UL), _s(0UL), _e(0UL), _q(0UL), _u(0UL),
+_delta(0.0)
+{
+    for (const Kind kind : { Reverse, Shift })
+        if (kinds & kind)
+            _kinds.push_back(kind);
+}
+
+template <typename Tour, typename Distance>
+double TourMoves<Tour, Distance>::_proposeReverse()
+{
+    const std::size_t n = _tour.size();
+
+    const std::size_t a = _random.below(n);
+
+    _c = _guided() ? _candidate(a) : _random.below(n);
+
+    _b = _tour.next(a);
+
+    const std::size_t d = _tour.next(_c);
+
+    if (_c == a || _c == _b || d == a)
+        return 0.0;
+
+    _valid = true;
+
+    return (*_distance)(a, _c) + (*_distance)(_b, d) - (*_distance)(a, _b) - (*_distance)(_c, d);
+}
+
+template <typename Tour, typename Distance>
+double TourMoves<Tour, Distance>::_proposeShift()
+{
+    const std::size_t n = _tour.size();
+
+    const std::size_t length = 1UL + _random.below(std::min<std::size_t>(3UL, n - 4UL));
+
+    _s = _random.below(n); _p = _tour.prev(_s);
+
+    _e = _s;
+    for (std::size_t l = 1UL; l < length; l++)
+        _e = _tour.next(_e);
+
+    _q = _tour.next(_e);
+
+    _u = _guided() ? _candidate(_s) : _random.below(n);
+
+    const std::size_t v = _tour.next(_u);
+
+    // Neither u nor v may belong to the segment
+    for (std::size_t id = _s; ; id = _tour.next(id))
+    {
+        if (id == _u || id == v)
+            return 0.0;
+
+        if (id == _e)
+            break;
+    }
+
+    _valid = true; _reversed = length > 1UL && _random.below(2UL);
+
+    const double removed = (*_distance)(_p, _s) + (*_distance)(_e, _q) + (*_distance)(_u, v);
+
+    const double added = (*_distance)(_p, _q) +
+    (
+        _reversed ?
+        (*_distance)(_u, _e) + (*_distance)(_s, v) :
+        (*_distance)(_u, _s) + (*_distance)(_e, v)
+    );
+
+    return added - removed;
+}
+
+template <typename Tour, typename Distance>
+double TourMoves<Tour, Distance>::propose()
+{
+    _valid = false;
+
+    // There is nothing to rearrange
+    if (_tour.size() < 5UL)
+        return _delta = 0.0;
+
+    _kind = _kinds[_random.below(_kinds.size())];
+
+    _delta = _kind == Reverse ? _proposeReverse() : _proposeShift();
+
+    return _delta;
+}
+
+template <typename Tour, typename Distance>
+void TourMoves<Tour, Distance>::apply()
+{
+    if (!_valid)
+        return;
+
+    if (_kind == Reverse)
+        _tour.reverse(_b, _c);
+    else
+    {
+        reversePath(_tour, _s, _u, _p);
+        reversePath(_tour, _u, _q, _p);
+
+        if (!_reversed)
+            reversePath(_tour, _e, _s, _p);
+    }
+
+    _cost += _delta; _valid = false;
+}
+
+template <typename Tour, typename Distance>
+void TourMoves<Tour, Distance>::save()
+{
+    _best = _tour; _bcost = _cost;
+}
+
+template <typename Tour, typename Distance>
+void TourMoves<Tour, Distance>::restore()
+{
+    _tour = _best; _cost = _bcost;
+}
+
+// Class WindowedMoves:
+template <typename Distance>
+WindowedMoves<Distance>::WindowedMoves
+(
+    const Distance& _distance,
+    const std::vector<double>& _service,
+    const std::vector<Timewindow>& _windows,
+    double _departureTime,
+    const std::vector<std::size_t>& _route,
+    int kinds
+)
+:
+_distance(&_distance),
+_service(&_service),
+_windows(&_windows),
+_random(),
+_departureTime(_departureTime),
+_route(_route),
+_best(_route),
+_arrival(_route.size() + 1UL, _departureTime),
+_penalties(_route.size() + 1UL, 0.0),
+_prefix(_route.size() + 1UL, 0.0),
+_late(_route.size() + 2UL, 0UL),
+_slack(_route.size() + 2UL, std::numeric_limits<double>::infinity()),
+_room(_route.size() + 2UL, std::numeric_limits<double>::infinity()),
+_kinds(),
+_lo(0UL), _hi(0UL),
+_ids(),
+_delta(0.0, 0.0)
+{
+    for (const Kind kind : { Swap, Shift })
+        if (kinds & kind)
+            _kinds.push_back(kind);
+
+    _rebuild(1UL);
+}
+
+template <typename Distance>
+double WindowedMoves<Distance>::_partialPenalty(std::size_t id, double arrivalTime) const
+{
+    const Timewindow& window = (*_windows)[id];
+
+    const double startOfService = std::max<double>(arrivalTime, window.first);
+
+    return std::max<double>(0.0, startOfService + (*_service)[id] - window.second);
+}
+
+// The penalty delta of the positions following and including p,
+// given that their arrival times are shifted by delta
+template <typename Distance>
+double WindowedMoves<Distance>::_suffixDelta(std::size_t p, double delta) const
+{
+    if (delta == 0.0)
+        return 0.0;
+
+    if (delta > 0.0 ? delta <= _slack[p] : -delta <= _room[p])
+        return delta * static_cast<double>(_late[p]);
+
+    double total = 0.0;
+    for (std::size_t q = p; q < _arrival.size(); q++)
+        total += _partialPenalty(_at(q), _arrival[q] + delta) - _penalties[q];
+
+    return total;
+}
+
+template <typename Distance>
+void WindowedMoves<Distance>::_rebuild(std::size_t from)
+{
+    const std::size_t last = _route.size();
+
+    for (std::size_t p = from; p <= last; p++)
+    {
+        const std::size_t i = _route[p - 1UL], j = _at(p);
+
+        _arrival[p]   = _arrival[p - 1UL] + (*_service)[i] + (*_distance)(i, j);
+        _penalties[p] = _partialPenalty(j, _arrival[p]);
+        _prefix[p]    = _prefix[p - 1UL] + _penalties[p];
+    }
+
+    for (std::size_t p = last; p >= 1UL; p--)
+    {
+        const std::size_t j = _at(p);
+
+        const Timewindow& window = (*_windows)[j];
+
+        double slack = std::numeric_limits<double>::infinity();
+        double room  = std::numeric_limits<double>::infinity();
+        std::size_t late = 0UL;
+
+        if (_penalties[p] <= 0.0)
+            slack = window.second - (*_service)[j] - _arrival[p];
+        else if (_arrival[p] < window.first)
+            slack = window.first - _arrival[p];
+        else
+        {
+            room = std::min(_penalties[p], _arrival[p] - window.first); late = 1UL;
+        }
+
+        _late[p]  = _late[p + 1UL] + late;
+        _slack[p] = std::min(_slack[p + 1UL], slack);
+        _room[p]  = std::min(_room[p + 1UL], room);
+    }
+}
+
+template <typename Distance>
+std::pair<double, double> WindowedMoves<Distance>::evaluate
+(
+    std::size_t lo,
+    std::size_t hi,
+    const std::vector<std::size_t>& ids
+) const
+{
+    double arrivalTime = _arrival[lo - 1UL], penalty = 0.0;
+
+    std::size_t previous = _route[lo - 1UL];
+    for (const std::size_t id : ids)
+    {
+        arrivalTime += (*_service)[previous] + (*_distance)(previous, id);
+
+        penalty += _partialPenalty(id, arrivalTime);
+
+        previous = id;
+    }
+
+    arrivalTime += (*_service)[previous] + (*_distance)(previous, _at(hi + 1UL));
+
+    // The cost of a route is the arrival time at its end minus the departure time
+    const double delta = arrivalTime - _arrival[hi + 1UL];
+
+    penalty += _prefix[lo - 1UL] + (_prefix.back() - _prefix[hi]) + _suffixDelta(hi + 1UL, delta);
+
+    return std::make_pair(delta, penalty - _prefix.back());
+}
+
+template <typename Distance>
+void WindowedMoves<Distance>::commit
+(
+    std::size_t lo,
+    std::size_t hi,
+    const std::vector<std::size_t>& ids
+)
+{
+    // The stops replace those at [lo, hi] one for one
+    assert(ids.size() == hi - lo + 1UL && hi < _route.size());
+
+    // Only checked unless NDEBUG is defined
+    static_cast<void>(hi);
+
+    std::copy(ids.begin(), ids.end(), _route.begin() + lo);
+
+    _rebuild(lo);
+}
+
+template <typename Distance>
+std::pair<double, double> WindowedMoves<Distance>::propose()
+{
+    const std::size_t n = _route.size() - 1UL;
+
+    // There is nothing to rearrange
+    if (n < 2UL)
+        return _delta = std::make_pair(0.0, 0.0);
+
+    std::size_t i = 1UL + _random.below(n);
+    std::size_t j = 1UL + _random.below(n - 1UL);
+
+    if (j >= i)
+        j++;
+
+    _lo = std::min(i, j); _hi = std::max(i, j);
+
+    _ids.assign(_route.begin() + _lo, _route.begin() + _hi + 1UL);
+
+    if (_kinds[_random.below(_kinds.size())] == Swap)
+        std::swap(_ids.front(), _ids.back());
+    else if (i < j)
+        std::rotate(_ids.begin(), _ids.begin() + 1, _ids.end());
+    else
+        std::rotate(_ids.begin(), _ids.end() - 1, _ids.end());
+
+    return _delta = evaluate(_lo, _hi, _ids);
+}
+
+template <typename Distance>
+void WindowedMoves<Distance>::apply()
+{
+    if (_route.size() < 3UL)
+        return;
+
+    commit(_lo, _hi, _ids);
+}
+
+template <typename Distance>
+void WindowedMoves<Distance>::save()
+{
+    _best = _route;
+}
+
+template <typename Distance>
+void WindowedMoves<Distance>::restore()
+{
+    _route = _best;
+
+    _rebuild(1UL);
+}
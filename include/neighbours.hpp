@@ -0,0 +1,44 @@
+
+#pragma once
+
+#include "kdtree.hpp"
+#include <vector>       // std::vector
+#include <cstddef>      // std::size_t
+
+// Candidate lists holding, for every id in [0, n), its k nearest ids
+// (and the corresponding distances) in ascending order of distance
+class Neighbours
+{
+    std::size_t _size, _k;
+
+    std::vector<std::size_t> _ids;
+
+    std::vector<double> _distances;
+
+public:
+
+    Neighbours();
+
+    template <typename Distance>
+    Neighbours(std::size_t, std::size_t, const Distance&);
+
+    // The points are queried by the specified number of threads concurrently,
+    // in which case the distance must be safe to evaluate concurrently
+    template <typename Distance>
+    Neighbours(const KDTree&, std::size_t, const Distance&, std::size_t = 1UL);
+
+    // The lists of the base, renumbered as by the specified ids of the base, followed by those of
+    // the ids added up to the specified size. Only the lists of the added ids and of those which
+    // lost a candidate are ranked anew, from the tree if any, whereas the added ids merely enter
+    // the lists they belong to; O(n) evaluations of the distance per added id
+    template <typename Distance>
+    Neighbours(const Neighbours&, const std::vector<std::size_t>&, std::size_t, const KDTree *, const Distance&);
+
+    std::size_t size() const { return _size; }
+    std::size_t k() const { return _k; }
+
+    std::size_t id(std::size_t i, std::size_t r) const { return _ids[i * _k + r]; }
+    double distance(std::size_t i, std::size_t r) const { return _distances[i * _k + r]; }
+};
+
+#include "neighbours.ipp"
@@ -0,0 +1,185 @@
+
+#pragma once
+
+#include "threadpool.hpp"
+#include <vector>       // std::vector
+#include <utility>      // std::pair
+#include <algorithm>    // std::partial_sort, std::stable_sort, std::upper_bound, std::copy_backward, std::min, std::max
+
+inline Neighbours::Neighbours()
+:
+_size(0UL), _k(0UL), _ids(), _distances()
+{
+}
+
+// Brute force construction; O(n^2) evaluations of the distance
+template <typename Distance>
+Neighbours::Neighbours(std::size_t _size, std::size_t k, const Distance& distance)
+:
+_size(_size),
+_k(_size > 0UL ? std::min(k, _size - 1UL) : 0UL),
+_ids(_size * _k),
+_distances(_size * _k)
+{
+    std::vector<std::pair<double, std::size_t>> candidates;
+    candidates.reserve(_size);
+
+    for (std::size_t i = 0UL; i < _size && _k > 0UL; i++)
+    {
+        candidates.clear();
+
+        for (std::size_t j = 0UL; j < _size; j++)
+            if (j != i)
+                candidates.emplace_back(distance(i, j), j);
+
+        std::partial_sort(candidates.begin(), candidates.begin() + _k, candidates.end());
+
+        for (std::size_t r = 0UL; r < _k; r++)
+        {
+            _distances[i * _k + r] = candidates[r].first;
+            _ids[i * _k + r]       = candidates[r].second;
+        }
+    }
+}
+
+// The k nearest points of the tree are ranked by the specified distance;
+// O(n log n) provided that the distance grows with the euclidean distance
+template <typename Distance>
+Neighbours::Neighbours(const KDTree& tree, std::size_t k, const Distance& distance, std::size_t threads)
+:
+_size(tree.size()),
+_k(_size > 0UL ? std::min(k, _size - 1UL) : 0UL),
+_ids(_size * _k),
+_distances(_size * _k)
+{
+    if (_k == 0UL)
+        return;
+
+    ThreadPool pool(threads > 1UL ? threads : 0UL);
+
+    // Every chunk of points fills its own rows
+    const std::size_t chunks = std::max<std::size_t>(1UL, 4UL * pool.size());
+
+    pool.parallel(chunks, [this, &tree, &distance, chunks](std::size_t c)
+    {
+        std::vector<std::pair<double, std::size_t>> candidates;
+        candidates.reserve(_k);
+
+        for (std::size_t i = _size * c / chunks; i < _size * (c + 1UL) / chunks; i++)
+        {
+            candidates.clear();
+
+            for (const std::size_t j : tree.nearest(tree.point(i), _k, i))
+                candidates.emplace_back(distance(i, j), j);
+
+            std::stable_sort(candidates.begin(), candidates.end());
+
+            // Removed points of the tree are made up for by repeating the farthest candidate
+            for (std::size_t r = 0UL; r < _k; r++)
+            {
+                const std::pair<double, std::size_t>& candidate = candidates[std::min(r, candidates.size() - 1UL)];
+
+                _distances[i * _k + r] = candidate.first;
+                _ids[i * _k + r]       = candidate.second;
+            }
+        }
+    });
+}
+
+template <typename Distance>
+Neighbours::Neighbours
+(
+    const Neighbours& base,
+    const std::vector<std::size_t>& kept,
+    std::size_t _size,
+    const KDTree * tree,
+    const Distance& distance
+)
+:
+_size(_size),
+_k(_size > 0UL ? std::min(base._k, _size - 1UL) : 0UL),
+_ids(_size * _k),
+_distances(_size * _k)
+{
+    if (_k == 0UL)
+        return;
+
+    std::vector<std::pair<double, std::size_t>> candidates;
+
+    auto rank = [this, tree, &distance, &candidates](std::size_t i)
+    {
+        candidates.clear();
+
+        if (tree)
+        {
+            for (const std::size_t j : tree->nearest(tree->point(i), _k, i))
+                candidates.emplace_back(distance(i, j), j);
+
+            std::stable_sort(candidates.begin(), candidates.end());
+        }
+        else
+        {
+            for (std::size_t j = 0UL; j < this->_size; j++)
+                if (j != i)
+                    candidates.emplace_back(distance(i, j), j);
+
+            std::partial_sort(candidates.begin(), candidates.begin() + _k, candidates.end());
+        }
+
+        for (std::size_t r = 0UL; r < _k; r++)
+        {
+            const std::pair<double, std::size_t>& candidate = candidates[std::min(r, candidates.size() - 1UL)];
+
+            _distances[i * _k + r] = candidate.first;
+            _ids[i * _k + r]       = candidate.second;
+        }
+    };
+
+    const std::size_t none = base._size;
+
+    std::vector<std::size_t> renumbered(base._size, none);
+    for (std::size_t i = 0UL; i < kept.size(); i++)
+        renumbered[kept[i]] = i;
+
+    // The lists ranked anew already take the added ids into account
+    std::vector<bool> ranked(_size, _k != base._k);
+
+    for (std::size_t i = 0UL; i < kept.size() && _k == base._k; i++)
+    {
+        for (std::size_t r = 0UL; r < _k; r++)
+        {
+            _ids[i * _k + r]       = renumbered[base.id(kept[i], r)];
+            _distances[i * _k + r] = base.distance(kept[i], r);
+
+            if (_ids[i * _k + r] == none)
+                ranked[i] = true;
+        }
+    }
+
+    for (std::size_t i = 0UL; i < _size; i++)
+        if (ranked[i] || i >= kept.size())
+            rank(i);
+
+    for (std::size_t added = kept.size(); added < _size; added++)
+    {
+        for (std::size_t i = 0UL; i < kept.size(); i++)
+        {
+            if (ranked[i])
+                continue;
+
+            const double d = distance(i, added);
+
+            double * distances = _distances.data() + i * _k;
+
+            if (!(d < distances[_k - 1UL]))
+                continue;
+
+            const std::size_t r = static_cast<std::size_t>(std::upper_bound(distances, distances + _k, d) - distances);
+
+            std::copy_backward(distances + r, distances + _k - 1UL, distances + _k);
+            std::copy_backward(_ids.begin() + i * _k + r, _ids.begin() + (i + 1UL) * _k - 1UL, _ids.begin() + (i + 1UL) * _k);
+
+            distances[r] = d; _ids[i * _k + r] = added;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include <cstdint>      // std::uint64_t
+#include <cstddef>      // std::size_t
+
+// A fast, seedable pseudo random number generator (xoshiro256**)
+// meant to be owned by a single thread. Generators constructed with the same seed,
+// but a different stream, produce independent sequences
+// @ http://prng.di.unimi.it/
+class Random
+{
+    std::uint64_t _s[4];
+
+    static std::uint64_t _rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+
+    using result_type = std::uint64_t;
+
+    Random(std::uint64_t seed = 0x853C49E6748FEA9BULL, std::uint64_t stream = 0ULL)
+    {
+        // The state is expanded from the seed by means of splitmix64
+        std::uint64_t x = seed + stream * 0xD1B54A32D192ED03ULL;
+
+        for (auto& s : _s)
+        {
+            std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+            s = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0ULL; }
+    static constexpr result_type max() { return ~0ULL; }
+
+    result_type operator()()
+    {
+        const std::uint64_t result = _rotl(_s[1] * 5ULL, 7) * 9ULL;
+        const std::uint64_t t = _s[1] << 17;
+
+        _s[2] ^= _s[0]; _s[3] ^= _s[1]; _s[1] ^= _s[2]; _s[0] ^= _s[3];
+
+        _s[2] ^= t; _s[3] = _rotl(_s[3], 45);
+
+        return result;
+    }
+
+    // A real number in [0, 1)
+    double uniform()
+    {
+        return static_cast<double>((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // An integer in [0, n)
+    std::size_t below(std::size_t n)
+    {
+        return static_cast<std::size_t>(uniform() * static_cast<double>(n));
+    }
+};
@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include "vector2.hpp"
+#include <vector>       // std::vector
+#include <cstddef>      // std::size_t
+#include <cstdint>      // std::uint8_t
+
+// Batched kernels vectorised for AVX2 and SSE2, alongside a scalar fallback.
+// The implementation is chosen at runtime, the first time any of them is called,
+// according to the instruction sets the processor supports; setting the
+// environment variable TSP_ISA to "sse2" or "scalar" caps the choice.
+// Every kernel returns the same result irrespective of the implementation
+namespace Simd
+{
+    // The instruction set the kernels were dispatched to ("avx2", "sse2" or "scalar")
+    const char * isa();
+
+    // out[i] = (xs[i] - x)^2 + (ys[i] - y)^2 for every i in [0, n)
+    void squared(const double *, const double *, double, double, std::size_t, double *);
+
+    // The first index in [0, n) minimizing values[i] amongst the ones whose mask is zero,
+    // or n if there is none
+    std::size_t argmin(const double *, const std::uint8_t *, std::size_t);
+
+    // The first index in [0, n) minimizing the squared distance from (x, y) to (xs[i], ys[i])
+    // amongst the ones whose mask is zero, or n if there is none
+    std::size_t nearest(const double *, const double *, double, double, const std::uint8_t *, std::size_t);
+}
+
+// The coordinates of a set of points stored as a structure of arrays
+class Points
+{
+    std::vector<double> _x, _y;
+
+public:
+
+    Points();
+    Points(const std::vector<Vector2>&);
+
+    std::size_t size() const { return _x.size(); }
+
+    double x(std::size_t i) const { return _x[i]; }
+    double y(std::size_t i) const { return _y[i]; }
+
+    const double * xs() const { return _x.data(); }
+    const double * ys() const { return _y.data(); }
+
+    // The squared euclidean distance from the specified point to the points [first, last)
+    void squared(const Vector2& point, std::size_t first, std::size_t last, double * out) const
+    {
+        Simd::squared(_x.data() + first, _y.data() + first, point.x(), point.y(), last - first, out);
+    }
+
+    // The first of the points nearest to the specified one whose mask is zero, or size() if none
+    std::size_t nearest(const Vector2& point, const std::uint8_t * mask) const
+    {
+        return Simd::nearest(_x.data(), _y.data(), point.x(), point.y(), mask, _x.size());
+    }
+};
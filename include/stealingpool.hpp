@@ -0,0 +1,67 @@
+
+#pragma once
+
+#include <functional>           // std::function
+#include <vector>               // std::vector
+#include <deque>                // std::deque
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <future>               // std::future
+#include <memory>               // std::unique_ptr
+#include <atomic>               // std::atomic
+#include <type_traits>          // std::result_of
+
+// A fixed number of worker threads, each owning a deque of tasks.
+// Tasks submitted by a worker are pushed onto its own deque, whereas those
+// submitted by any other thread are dealt to the workers in turn.
+// A worker pops its own tasks in LIFO order and, once out of them,
+// steals the oldest task of another worker.
+// A pool of zero workers executes every task synchronously upon its submission
+class WorkStealingPool
+{
+    struct Queue
+    {
+        std::deque<std::function<void()>> tasks;
+
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+
+    std::vector<std::thread> _workers;
+
+    // Workers sleep on the condition while no task is pending
+    std::mutex _mutex;
+
+    std::condition_variable _condition;
+
+    std::size_t _pending;
+
+    bool _stopping;
+
+    std::atomic<std::size_t> _next;
+
+    void _push(std::function<void()>&&);
+
+    bool _pop(std::size_t, std::function<void()>&);
+
+    void _work(std::size_t);
+
+public:
+
+    WorkStealingPool(std::size_t = std::thread::hardware_concurrency());
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Pending tasks are still executed before the workers are joined
+    ~WorkStealingPool();
+
+    std::size_t size() const { return _workers.size(); }
+
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> submit(F&&);
+};
+
+#include "stealingpool.ipp"
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>       // std::make_shared
+#include <future>       // std::packaged_task
+#include <utility>      // std::forward
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> WorkStealingPool::submit(F&& f)
+{
+    using R = typename std::result_of<F()>::type;
+
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+
+    std::future<R> future = task->get_future();
+
+    if (_workers.empty())
+    {
+        (*task)();
+
+        return future;
+    }
+
+    _push([task]() { (*task)(); });
+
+    return future;
+}
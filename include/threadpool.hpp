@@ -0,0 +1,54 @@
+
+#pragma once
+
+#include <functional>           // std::function
+#include <vector>               // std::vector
+#include <deque>                // std::deque
+#include <thread>               // std::thread
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <future>               // std::future
+#include <type_traits>          // std::result_of
+
+// A fixed number of worker threads executing the submitted tasks in FIFO order.
+// A pool of zero workers executes every task synchronously upon its submission
+class ThreadPool
+{
+    std::vector<std::thread> _workers;
+
+    std::deque<std::function<void()>> _tasks;
+
+    std::mutex _mutex;
+
+    std::condition_variable _condition;
+
+    bool _stopping;
+
+    void _work();
+
+public:
+
+    ThreadPool(std::size_t = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    std::size_t size() const { return _workers.size(); }
+
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> submit(F&&);
+
+    // Executes f(0), f(1), ..., f(count - 1) concurrently
+    // and blocks until all of them have returned
+    template <typename F>
+    void parallel(std::size_t, const F&);
+
+    // Sorts a chunk of the range per worker concurrently,
+    // then merges adjacent chunks pairwise; not stable
+    template <typename Iterator, typename Compare>
+    void sort(Iterator, Iterator, const Compare&);
+};
+
+#include "threadpool.ipp"
@@ -0,0 +1,95 @@
+
+#pragma once
+
+#include <memory>       // std::make_shared
+#include <future>       // std::packaged_task
+#include <utility>      // std::forward
+#include <vector>       // std::vector
+#include <algorithm>    // std::sort, std::inplace_merge, std::max
+#include <iterator>     // std::distance, std::next
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> ThreadPool::submit(F&& f)
+{
+    using R = typename std::result_of<F()>::type;
+
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+
+    std::future<R> future = task->get_future();
+
+    if (_workers.empty())
+    {
+        (*task)();
+
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _tasks.emplace_back([task]() { (*task)(); });
+    }
+
+    _condition.notify_one();
+
+    return future;
+}
+
+template <typename F>
+void ThreadPool::parallel(std::size_t count, const F& f)
+{
+    std::vector<std::future<void>> futures; futures.reserve(count);
+
+    for (std::size_t i = 0UL; i < count; i++)
+        futures.push_back(submit([&f, i]() { f(i); }));
+
+    // Rethrows the exception of the first task that failed, if any
+    for (auto& future : futures)
+        future.get();
+}
+
+template <typename Iterator, typename Compare>
+void ThreadPool::sort(Iterator first, Iterator last, const Compare& compare)
+{
+    const std::size_t size = static_cast<std::size_t>(std::distance(first, last));
+
+    // Chunks too small to be worth a task are sorted synchronously
+    const std::size_t minimum = 4096UL;
+
+    std::size_t chunks = std::max<std::size_t>(1UL, _workers.size());
+
+    if (size / chunks < minimum)
+        chunks = std::max<std::size_t>(1UL, size / minimum);
+
+    if (chunks == 1UL)
+    {
+        std::sort(first, last, compare);
+
+        return;
+    }
+
+    // The boundaries of the chunks
+    std::vector<Iterator> bounds; bounds.reserve(chunks + 1UL);
+
+    for (std::size_t c = 0UL; c <= chunks; c++)
+        bounds.push_back(std::next(first, static_cast<std::ptrdiff_t>(size * c / chunks)));
+
+    parallel(chunks, [&bounds, &compare](std::size_t c)
+    {
+        std::sort(bounds[c], bounds[c + 1UL], compare);
+    });
+
+    // Merging the pairs of adjacent runs of every round concurrently
+    for (std::size_t width = 1UL; width < chunks; width *= 2UL)
+    {
+        const std::size_t pairs = (chunks + 2UL * width - 1UL) / (2UL * width);
+
+        parallel(pairs, [&bounds, &compare, width, chunks](std::size_t p)
+        {
+            const std::size_t lo = 2UL * width * p, mid = lo + width;
+
+            if (mid < chunks)
+                std::inplace_merge(bounds[lo], bounds[mid], bounds[std::min(lo + 2UL * width, chunks)], compare);
+        });
+    }
+}
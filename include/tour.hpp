@@ -0,0 +1,145 @@
+
+#pragma once
+
+#include <vector>       // std::vector
+#include <cstddef>      // std::size_t
+
+// A cyclic tour over the ids [0, n) stored as a plain array
+// together with the position of every id
+class ArrayTour
+{
+    std::vector<std::size_t> _order;
+
+    std::vector<std::size_t> _position;
+
+public:
+
+    ArrayTour();
+    ArrayTour(const std::vector<std::size_t>&);
+
+    std::size_t size() const { return _order.size(); }
+
+    std::size_t next(std::size_t id) const
+    {
+        const std::size_t p = _position[id] + 1UL;
+
+        return _order[p == _order.size() ? 0UL : p];
+    }
+
+    std::size_t prev(std::size_t id) const
+    {
+        const std::size_t p = _position[id];
+
+        return _order[p == 0UL ? _order.size() - 1UL : p - 1UL];
+    }
+
+    // Whether b lies on the path travelling forward from a to c
+    bool between(std::size_t, std::size_t, std::size_t) const;
+
+    // Reverses the path travelling forward from the first to the second id
+    // (or, equivalently, its complement, whichever is shorter)
+    void reverse(std::size_t, std::size_t);
+
+    // The ids in tour order starting from the specified one
+    std::vector<std::size_t> order(std::size_t) const;
+};
+
+// A cyclic tour over the ids [0, n) split into about sqrt(n) segments,
+// each of which may be traversed backwards. Reversing a path splits at most
+// two segments and reverses the order of the ones in between, hence costs
+// O(sqrt(n)) instead of O(n); the segments are rebuilt once too fragmented
+// @ Fredman, M. L., et al. (1995). Data structures for traveling salesmen
+class TwoLevelTour
+{
+    struct Segment
+    {
+        std::vector<std::size_t> ids;
+
+        bool reversed;
+
+        // The position of the segment in the tour
+        std::size_t rank;
+    };
+
+    std::vector<Segment> _segments;
+
+    // The segments in tour order
+    std::vector<std::size_t> _order;
+
+    // The segment of every id and its index amongst the ids of the segment
+    std::vector<std::size_t> _segment, _offset;
+
+    std::size_t _size, _group;
+
+    std::size_t _position(std::size_t id) const
+    {
+        const Segment& segment = _segments[_segment[id]];
+
+        return segment.reversed ? segment.ids.size() - 1UL - _offset[id] : _offset[id];
+    }
+
+    std::size_t _at(const Segment& segment, std::size_t p) const
+    {
+        return segment.ids[segment.reversed ? segment.ids.size() - 1UL - p : p];
+    }
+
+    void _build(const std::vector<std::size_t>&);
+
+    // Makes the specified id the first of its segment
+    void _split(std::size_t);
+
+public:
+
+    // The number of ids above which a TwoLevelTour outperforms an ArrayTour
+    static constexpr std::size_t threshold = 5000UL;
+
+    TwoLevelTour();
+    TwoLevelTour(const std::vector<std::size_t>&);
+
+    std::size_t size() const { return _size; }
+
+    std::size_t next(std::size_t id) const
+    {
+        const Segment& segment = _segments[_segment[id]];
+
+        const std::size_t p = _position(id) + 1UL;
+
+        if (p < segment.ids.size())
+            return _at(segment, p);
+
+        const std::size_t rank = segment.rank + 1UL;
+
+        return _at(_segments[_order[rank == _order.size() ? 0UL : rank]], 0UL);
+    }
+
+    std::size_t prev(std::size_t id) const
+    {
+        const Segment& segment = _segments[_segment[id]];
+
+        const std::size_t p = _position(id);
+
+        if (p > 0UL)
+            return _at(segment, p - 1UL);
+
+        const Segment& previous = _segments[_order[segment.rank == 0UL ? _order.size() - 1UL : segment.rank - 1UL]];
+
+        return _at(previous, previous.ids.size() - 1UL);
+    }
+
+    bool between(std::size_t, std::size_t, std::size_t) const;
+
+    void reverse(std::size_t, std::size_t);
+
+    std::vector<std::size_t> order(std::size_t) const;
+};
+
+// Reverses the path whose endpoints are u and v, which does not contain x,
+// irrespective of the direction the tour is currently traversed in
+template <typename Tour>
+void reversePath(Tour& tour, std::size_t u, std::size_t v, std::size_t x)
+{
+    if (tour.between(u, x, v))
+        tour.reverse(v, u);
+    else
+        tour.reverse(u, v);
+}
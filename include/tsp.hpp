@@ -1,112 +1,352 @@
 
 #pragma once
 
+#include "annealing.hpp"
+#include "localsearch.hpp"
+#include "matrix.hpp"
+#include "kdtree.hpp"
+#include "neighbours.hpp"
+#include "decomposition.hpp"
+#include "memetic.hpp"
 #include <utility>      // std::pair
 #include <functional>   // std::function
 #include <vector>       // std::vector
+#include <memory>       // std::shared_ptr
+#include <mutex>        // std::mutex
 #include <iosfwd>       // std::ostream
-#include <utility>      // std::pair
+#include <type_traits>  // std::integral_constant
+#include <thread>       // std::thread
 
-template <typename T>
-class tsp;
+// The service time and duration policies may be any callables of the signatures
+// double(const T&) and double(const T&, const T&) respectively, which are then
+// evaluated in place rather than through a type erased wrapper.
+// Default construction requires default constructible policies
+template <typename T, typename ServiceTime, typename Duration>
+class basic_tsp;
 
-template <typename T>
-std::ostream& operator<<(std::ostream&, const tsp<T>&);
+template <typename T, typename ServiceTime, typename Duration>
+std::ostream& operator<<(std::ostream&, const basic_tsp<T, ServiceTime, Duration>&);
 
 template <typename T>
-class tsp
+using tsp = basic_tsp<T, std::function<double(const T&)>, std::function<double(const T&, const T&)>>;
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> make_tsp(const T&, const std::vector<T>&, const ServiceTime&, const Duration&, bool = false);
+
+template <typename T, typename ServiceTime, typename Duration>
+class basic_tsp
 {
 protected:
 
+    // The problem data shared by every route over the same stops.
+    // Each stop is identified by an integer id; the depot by 0
+    // and the i-th element by i + 1
+    struct Instance
+    {
+        std::vector<T> stops;
+
+        ServiceTime serviceTime;
+
+        Duration duration;
+
+        std::vector<double> service;
+
+        DistanceMatrix matrix;
+
+        // A spatial index over the stops, provided that Spatial<T> is specialized
+        // and that the duration is stated to grow with their euclidean distance
+        std::shared_ptr<const KDTree> tree;
+
+        // The candidate lists last built, guarded by the mutex,
+        // which the instances derived from this one patch rather than build anew
+        mutable std::shared_ptr<const Neighbours> neighbours;
+
+        mutable std::mutex mutex;
+
+        static std::shared_ptr<const KDTree> index(const std::vector<T>&, std::true_type);
+        static std::shared_ptr<const KDTree> index(const std::vector<T>&, std::false_type);
+
+        // The tree of the base patched as by KDTree
+        static std::shared_ptr<const KDTree> index(const Instance&, const std::vector<std::size_t>&, const std::vector<T>&, std::true_type);
+        static std::shared_ptr<const KDTree> index(const Instance&, const std::vector<std::size_t>&, const std::vector<T>&, std::false_type);
+
+        // The depot followed by the elements
+        static std::vector<T> join(const T&, const std::vector<T>&);
+
+        static std::vector<double> measure(const std::vector<T>&, const ServiceTime&);
+
+        Instance();
+        Instance
+        (
+            const T&,
+            const std::vector<T>&,
+            const ServiceTime&,
+            const Duration&,
+            bool
+        );
+
+        Instance
+        (
+            const T&,
+            const std::vector<T>&,
+            const ServiceTime&,
+            const Duration&,
+            const std::shared_ptr<const double>&,
+            bool
+        );
+
+        // The specified stops of the base, in the specified order and starting with the depot,
+        // followed by the additional stops. The durations amongst the stops of the base
+        // are looked up in its matrix, which is shared, rather than evaluated anew,
+        // and its spatial index, if any, and candidate lists are patched rather than built anew
+        Instance(const std::shared_ptr<const Instance>&, const std::vector<std::size_t>&, const std::vector<T>&);
+    };
+
+    std::shared_ptr<const Instance> _instance;
+
+    std::vector<std::size_t> _tour;
+
     T _depot;
 
     std::vector<T> _elements;
-    
-    std::function<double(const T&)> _serviceTime;
-
-    std::function<double(const T&, const T&)> _duration;
 
     double _cost;
 
-    double _partialCost(const T&, const T&) const;
+    double _partialCost(std::size_t, std::size_t) const;
     double _totalCost() const;
 
+    bool _shares(const basic_tsp& other) const { return _instance == other._instance; }
+
+    // The candidate lists of every stop with respect to the duration, built by the specified
+    // number of threads unless those of the instance already hold as many candidates
+    Neighbours _neighbours(std::size_t, std::size_t = 1UL) const;
+
+    // The id of the stop, if amongst the elements, or 0 otherwise
+    std::size_t _find(const T&) const;
+
+    // Runs the specified local search on the tour, including the depot,
+    // building the candidate lists by the specified number of threads
+    template <typename Search>
+    basic_tsp _improve(const Search&, const LocalSearch::Options&, std::size_t = 1UL) const;
+
+    basic_tsp(const std::shared_ptr<const Instance>&, const std::vector<std::size_t>&);
+
 public:
 
-    tsp();
-    tsp
+    basic_tsp();
+
+    // Only should the last argument state that the duration between two stops grows
+    // with their euclidean distance, and provided that Spatial<T> is specialized,
+    // are the stops indexed by a KDTree, which the solvers consult instead of
+    // scanning every pair of stops
+    basic_tsp
     (
         const T&,
         const std::vector<T>&,
-        const std::function<double(const T&)>&,
-        const std::function<double(const T&, const T&)>&
+        const ServiceTime&,
+        const Duration&,
+        bool = false
     );
 
-    tsp(const tsp&);
-    tsp(tsp&&) noexcept;
+    // The durations are not evaluated but looked up in the specified dense matrix
+    // over the depot and the elements, laid out as by DistanceMatrix
+    // (e.g. memory mapped by a BinaryInstance), whose ownership is shared.
+    // The duration is still used for the stops inserted later on
+    basic_tsp
+    (
+        const T&,
+        const std::vector<T>&,
+        const ServiceTime&,
+        const Duration&,
+        const std::shared_ptr<const double>&,
+        bool = false
+    );
+
+    basic_tsp(const basic_tsp&);
+    basic_tsp(basic_tsp&&) noexcept;
 
-    tsp& operator=(const tsp&);
-    tsp& operator=(tsp&&) noexcept;
+    basic_tsp& operator=(const basic_tsp&);
+    basic_tsp& operator=(basic_tsp&&) noexcept;
 
     const T& depot() const { return _depot; }
     const std::vector<T>& elements() const { return _elements; }
 
     double cost() const { return _cost; }
 
-    friend std::ostream& operator<< <T>(std::ostream&, const tsp&);
+    friend std::ostream& operator<< <T, ServiceTime, Duration>(std::ostream&, const basic_tsp&);
+
+    basic_tsp nneighbour() const;
+
+    // Orders the stops along a Hilbert curve, provided that they are spatially indexed,
+    // sorting in parallel; otherwise falls back to nneighbour
+    basic_tsp hilbert(std::size_t = std::thread::hardware_concurrency()) const;
 
-    tsp nneighbour() const;
-    tsp opt2() const;
-    tsp sannealing() const;
+    // Repeatedly links the shortest candidate edge that neither gives a stop a third
+    // neighbour nor closes a cycle, then joins the fragments by their nearest endpoints
+    basic_tsp greedy(std::size_t = std::thread::hardware_concurrency()) const;
+
+    basic_tsp opt2(const LocalSearch::Options& = LocalSearch::Options()) const;
+    basic_tsp oropt(const LocalSearch::Options& = LocalSearch::Options()) const;
+    basic_tsp or3opt(const LocalSearch::Options& = LocalSearch::Options()) const;
+
+    // Keeps perturbing the tour for options.kicks times or options.seconds
+    basic_tsp linkernighan(const LocalSearch::Options& = LocalSearch::Options()) const;
+    basic_tsp sannealing(const Annealing::Parallel& = Annealing::Parallel(), const Control& = Control()) const;
+
+    // Follows the specified schedule for up to a million iterations per chain
+    // instead of the default geometric one
+    basic_tsp sannealing(const Annealing::Schedule&, const Annealing::Parallel& = Annealing::Parallel(), const Control& = Control()) const;
+
+    // Evolves a population of variations of the tour by edge assembly crossover,
+    // repairing every child by means of opt2 and oropt around the edges it inherited
+    basic_tsp memetic(const Memetic::Options& = Memetic::Options(), const Control& = Control()) const;
+
+    // Solves the clusters of a spatial partition of the stops concurrently,
+    // by means of linkernighan and oropt, and stitches their cycles together.
+    // Without a spatial index, the tour is improved by the same searches as a whole.
+    // The wall clock budget of options.search covers the whole decomposition,
+    // whereas the progress is only reported by the final repair
+    basic_tsp decompose(const Decomposition::Options& = Decomposition::Options()) const;
+
+    // Inserts the stop where it lengthens the tour the least, only considering the edges
+    // incident to its nearest stops provided that they are spatially indexed,
+    // and improves the tour around it by means of opt2 and oropt.
+    // Throws std::invalid_argument should the stop be the depot or already amongst the elements
+    basic_tsp insert(const T&, const LocalSearch::Options& = LocalSearch::Options()) const;
+
+    // Removes the stop, the tour being left empty should it be the only element,
+    // and improves the tour around the gap by means of opt2 and oropt.
+    // Throws std::invalid_argument should the stop be the depot or not amongst the elements
+    basic_tsp remove(const T&, const LocalSearch::Options& = LocalSearch::Options()) const;
 };
 
-template <typename T>
-class tsptw;
+// The timewindow policy may be any callable of the signature std::pair<double, double>(const T&)
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+class basic_tsptw;
 
-template <typename T>
-std::ostream& operator<<(std::ostream&, const tsptw<T>&);
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+std::ostream& operator<<(std::ostream&, const basic_tsptw<T, ServiceTime, Duration, Window>&);
 
 template <typename T>
-class tsptw : public tsp<T>
+using tsptw = basic_tsptw
+<
+    T,
+    std::function<double(const T&)>,
+    std::function<double(const T&, const T&)>,
+    std::function<std::pair<double, double>(const T&)>
+>;
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> make_tsptw(const T&, const std::vector<T>&, const ServiceTime&, const Duration&, double, const Window&, bool = false);
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+class basic_tsptw : public basic_tsp<T, ServiceTime, Duration>
 {
+    using base = basic_tsp<T, ServiceTime, Duration>;
+
+public:
+
+    using Timewindow = std::pair<double, double>;
+
+private:
+
+    // The timewindow of every stop indexed by its id
+    struct Timewindows
+    {
+        Window function;
+
+        std::vector<Timewindow> windows;
+
+        Timewindows(const Window& function) : function(function), windows() {}
+    };
+
     double _departureTime;
 
-    std::function<std::pair<double, double>(const T&)> _timewindow;
+    std::shared_ptr<const Timewindows> _timewindows;
 
     double _penalty;
 
-    double _partialPenalty(double&, const T&, const T&) const;
+    double _partialPenalty(double&, std::size_t, std::size_t) const;
     double _totalPenalty() const;
 
+    std::shared_ptr<const Timewindows> _mapTimewindows(const Window&) const;
+
+    // The timewindows of the specified ids, followed by those of the remaining stops
+    std::shared_ptr<const Timewindows> _mapTimewindows(const std::vector<std::size_t>&, const std::vector<T>&) const;
+
+    // Runs the specified timewindow aware local search on the route
+    template <typename Search>
+    basic_tsptw _improve(const Search&, const LocalSearch::Options&) const;
+
+    basic_tsptw(const basic_tsptw&, const std::vector<std::size_t>&);
+    basic_tsptw(const basic_tsptw&, const std::shared_ptr<const typename base::Instance>&, const std::shared_ptr<const Timewindows>&, const std::vector<std::size_t>&);
+
 public:
 
-    using Timewindow = std::pair<double, double>;
+    basic_tsptw();
 
-    tsptw();
-    tsptw
+    // The stops are spatially indexed only if so stated, as by basic_tsp
+    basic_tsptw
     (
         const T& depot,
         const std::vector<T>&,
-        const std::function<double(const T&)>&,
-        const std::function<double(const T&, const T&)>&,
+        const ServiceTime&,
+        const Duration&,
         double,
-        const std::function<Timewindow(const T&)>&
+        const Window&,
+        bool = false
     );
-    
-    tsptw(const tsptw&);
-    tsptw(tsptw&&) noexcept;
 
-    tsptw& operator=(const tsptw&);
-    tsptw& operator=(tsptw&&) noexcept;
+    // The durations are looked up in the specified dense matrix, as by basic_tsp
+    basic_tsptw
+    (
+        const T& depot,
+        const std::vector<T>&,
+        const ServiceTime&,
+        const Duration&,
+        double,
+        const Window&,
+        const std::shared_ptr<const double>&,
+        bool = false
+    );
+
+    basic_tsptw(const basic_tsptw&);
+    basic_tsptw(basic_tsptw&&) noexcept;
 
-    tsptw& operator=(const tsp<T>&);
-    tsptw& operator=(tsp<T>&&) noexcept;
+    basic_tsptw& operator=(const basic_tsptw&);
+    basic_tsptw& operator=(basic_tsptw&&) noexcept;
+
+    basic_tsptw& operator=(const base&);
+    basic_tsptw& operator=(base&&) noexcept;
 
     double penalty() const { return _penalty; }
 
-    friend std::ostream& operator<< <T>(std::ostream&, const tsptw&);
+    friend std::ostream& operator<< <T, ServiceTime, Duration, Window>(std::ostream&, const basic_tsptw&);
+
+    // Unlike opt2, which ignores the timewindows, these never increase the penalty
+    basic_tsptw oropt(const LocalSearch::Options& = LocalSearch::Options()) const;
+    basic_tsptw or3opt(const LocalSearch::Options& = LocalSearch::Options()) const;
+
+    basic_tsptw cannealing(const Annealing::Parallel& = Annealing::Parallel(), const Control& = Control()) const;
+
+    // Skips the calibration if already calibrated; otherwise stores the one carried out,
+    // unless the budget cut it short, in which case the calibration is left uncalibrated
+    basic_tsptw cannealing(Annealing::Calibration&, const Annealing::Parallel& = Annealing::Parallel(), const Control& = Control()) const;
+
+    // As basic_tsp::memetic, but the children traverse what they inherit in the direction
+    // of their parents, are repaired by means of oropt and or3opt
+    // and are the fitter the lower their penalty and then their cost
+    basic_tsptw memetic(const Memetic::Options& = Memetic::Options(), const Control& = Control()) const;
+
+    // Inserts the stop where it increases the penalty, or else the cost, the least
+    // and improves the route around it by means of oropt and or3opt.
+    // Throws std::invalid_argument should the stop be the depot or already amongst the elements
+    basic_tsptw insert(const T&, const LocalSearch::Options& = LocalSearch::Options()) const;
 
-    tsptw cannealing() const;
+    // Removes the stop, the route being left empty should it be the only element,
+    // and improves the route around the gap by means of oropt and or3opt.
+    // Throws std::invalid_argument should the stop be the depot or not amongst the elements
+    basic_tsptw remove(const T&, const LocalSearch::Options& = LocalSearch::Options()) const;
 };
 
 #include "tsp.ipp"
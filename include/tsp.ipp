@@ -2,376 +2,1574 @@
 #pragma once
 
 #include "annealing.hpp"
-#include <functional>       // std::function
+#include "localsearch.hpp"
+#include "moves.hpp"
+#include "tour.hpp"
+#include "simd.hpp"
+#include "hilbert.hpp"
+#include "threadpool.hpp"
+#include "instrument.hpp"
+#include <functional>       // std::less
 #include <vector>           // std::vector
+#include <memory>           // std::make_shared, std::unique_ptr
+#include <mutex>            // std::lock_guard
 #include <utility>          // std::pair
 #include <fstream>          // std::ostream
 #include <iomanip>          // std::setw
-#include <algorithm>        // std::reverse
+#include <algorithm>        // std::find, std::find_if, std::min, std::max
 #include <stdexcept>        // std::invalid_argument
 #include <limits>           // std::numeric_limits
+#include <cstdint>          // std::uint8_t, std::uint64_t
 
-// Class tsp:
-template <typename  T>
-double tsp<T>::_partialCost(const T& A, const T& B) const
+// Struct basic_tsp::Instance:
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::Instance::Instance()
+:
+stops(),
+serviceTime(),
+duration(),
+service(),
+matrix(),
+tree(),
+neighbours(),
+mutex()
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::Instance::Instance
+(
+    const T& depot,
+    const std::vector<T>& elements,
+    const ServiceTime& serviceTime,
+    const Duration& duration,
+    bool euclidean
+)
+:
+stops(join(depot, elements)),
+serviceTime(serviceTime),
+duration(duration),
+service(measure(stops, serviceTime)),
+matrix
+(
+    stops.size(),
+    [this](std::size_t i, std::size_t j) { return this->duration(stops[i], stops[j]); }
+),
+tree(euclidean ? index(stops, std::integral_constant<bool, Spatial<T>::value>()) : nullptr),
+neighbours(),
+mutex()
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::Instance::Instance
+(
+    const T& depot,
+    const std::vector<T>& elements,
+    const ServiceTime& serviceTime,
+    const Duration& duration,
+    const std::shared_ptr<const double>& durations,
+    bool euclidean
+)
+:
+stops(join(depot, elements)),
+serviceTime(serviceTime),
+duration(duration),
+service(measure(stops, serviceTime)),
+matrix(stops.size(), durations),
+tree(euclidean ? index(stops, std::integral_constant<bool, Spatial<T>::value>()) : nullptr),
+neighbours(),
+mutex()
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::vector<T> basic_tsp<T, ServiceTime, Duration>::Instance::join(const T& depot, const std::vector<T>& elements)
+{
+    if (std::find(elements.begin(), elements.end(), depot) != elements.end())
+        throw std::invalid_argument("depot amongst the elements");
+
+    std::vector<T> stops; stops.reserve(elements.size() + 1UL);
+
+    stops.push_back(depot);
+    stops.insert(stops.end(), elements.begin(), elements.end());
+
+    return stops;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::vector<double> basic_tsp<T, ServiceTime, Duration>::Instance::measure(const std::vector<T>& stops, const ServiceTime& serviceTime)
+{
+    std::vector<double> service; service.reserve(stops.size());
+
+    for (const auto& stop : stops)
+        service.push_back(serviceTime(stop));
+
+    return service;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::Instance::Instance
+(
+    const std::shared_ptr<const Instance>& base,
+    const std::vector<std::size_t>& kept,
+    const std::vector<T>& additions
+)
+:
+stops([&base, &kept, &additions]()
+{
+    std::vector<T> stops; stops.reserve(kept.size() + additions.size());
+
+    for (const auto id : kept)
+        stops.push_back(base->stops[id]);
+
+    stops.insert(stops.end(), additions.begin(), additions.end());
+
+    return stops;
+}()),
+serviceTime(base->serviceTime),
+duration(base->duration),
+service([this, &base, &kept, &additions]()
+{
+    std::vector<double> service; service.reserve(stops.size());
+
+    for (const auto id : kept)
+        service.push_back(base->service[id]);
+
+    for (const auto& stop : additions)
+        service.push_back(this->serviceTime(stop));
+
+    return service;
+}()),
+matrix
+(
+    std::shared_ptr<const DistanceMatrix>(base, &base->matrix),
+    kept,
+    stops.size(),
+    [this](std::size_t i, std::size_t j) { return this->duration(stops[i], stops[j]); }
+),
+tree(base->tree ? index(*base, kept, additions, std::integral_constant<bool, Spatial<T>::value>()) : nullptr),
+neighbours(),
+mutex()
+{
+    std::lock_guard<std::mutex> lock(base->mutex);
+
+    if (base->neighbours)
+        neighbours = std::make_shared<const Neighbours>
+        (
+            *base->neighbours,
+            kept,
+            stops.size(),
+            tree.get(),
+            [this](std::size_t i, std::size_t j) { return matrix.peek(i, j); }
+        );
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::shared_ptr<const KDTree> basic_tsp<T, ServiceTime, Duration>::Instance::index(const std::vector<T>& stops, std::true_type)
+{
+    std::vector<Vector2> positions; positions.reserve(stops.size());
+
+    for (const auto& stop : stops)
+        positions.push_back(Spatial<T>::position(stop));
+
+    return std::make_shared<const KDTree>(positions);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::shared_ptr<const KDTree> basic_tsp<T, ServiceTime, Duration>::Instance::index(const std::vector<T>&, std::false_type)
+{
+    return nullptr;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::shared_ptr<const KDTree> basic_tsp<T, ServiceTime, Duration>::Instance::index
+(
+    const Instance& base,
+    const std::vector<std::size_t>& kept,
+    const std::vector<T>& additions,
+    std::true_type
+)
+{
+    std::vector<Vector2> positions; positions.reserve(additions.size());
+
+    for (const auto& stop : additions)
+        positions.push_back(Spatial<T>::position(stop));
+
+    return std::make_shared<const KDTree>(*base.tree, kept, positions);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::shared_ptr<const KDTree> basic_tsp<T, ServiceTime, Duration>::Instance::index
+(
+    const Instance&,
+    const std::vector<std::size_t>&,
+    const std::vector<T>&,
+    std::false_type
+)
+{
+    return nullptr;
+}
+
+// Class basic_tsp:
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> make_tsp
+(
+    const T& depot,
+    const std::vector<T>& elements,
+    const ServiceTime& serviceTime,
+    const Duration& duration,
+    bool euclidean
+)
+{
+    return basic_tsp<T, ServiceTime, Duration>(depot, elements, serviceTime, duration, euclidean);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+double basic_tsp<T, ServiceTime, Duration>::_partialCost(std::size_t i, std::size_t j) const
+{
+    // Only ever summed along the tour once, hence not worth filling the rows of a lazy matrix
+    return _instance->service[i] + _instance->matrix.peek(i, j);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+double basic_tsp<T, ServiceTime, Duration>::_totalCost() const
+{
+    // Without any element, the depot is never left
+    if (_tour.empty())
+        return 0.0;
+
+    double _cost = _partialCost(0UL, _tour.front());
+
+    for (std::size_t j = 0; j < _tour.size() - 1UL; j++)
+        _cost += _partialCost(_tour[j], _tour[j + 1UL]);
+
+    _cost += _partialCost(_tour.back(), 0UL);
+
+    return _cost;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+Neighbours basic_tsp<T, ServiceTime, Duration>::_neighbours(std::size_t k, std::size_t threads) const
+{
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    const std::size_t n = _instance->stops.size();
+
+    std::lock_guard<std::mutex> lock(_instance->mutex);
+
+    std::shared_ptr<const Neighbours>& neighbours = _instance->neighbours;
+
+    if (neighbours && neighbours->k() == (n > 0UL ? std::min(k, n - 1UL) : 0UL))
+        return *neighbours;
+
+    // Every row is only ranked once
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix.peek(i, j);
+    };
+
+    if (_instance->tree)
+        neighbours = std::make_shared<const Neighbours>(*_instance->tree, k, distance, threads);
+    else
+        neighbours = std::make_shared<const Neighbours>(n, k, distance);
+
+    return *neighbours;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::size_t basic_tsp<T, ServiceTime, Duration>::_find(const T& stop) const
 {
-    return _serviceTime(A) + _duration(A, B);
+    const auto it = std::find(_elements.begin(), _elements.end(), stop);
+
+    return it == _elements.end() ? 0UL : _tour[it - _elements.begin()];
 }
 
-template <typename T>
-double tsp<T>::_totalCost() const
-{    
-    double _cost = _partialCost(_depot, _elements.front());
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::basic_tsp()
+:
+_instance(std::make_shared<const Instance>()),
+_tour(),
+_depot(),
+_elements(),
+_cost(std::numeric_limits<double>().max())
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::basic_tsp
+(
+    const T& _depot,
+    const std::vector<T>& _elements,
+    const ServiceTime& _serviceTime,
+    const Duration& _duration,
+    bool euclidean
+)
+:
+_instance(std::make_shared<const Instance>(_depot, _elements, _serviceTime, _duration, euclidean)),
+_tour(_elements.size()),
+_depot(_depot),
+_elements(_elements)
+{
+    for (std::size_t j = 0UL; j < _tour.size(); j++)
+        _tour[j] = j + 1UL;
+
+    _cost = _totalCost();
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::basic_tsp
+(
+    const T& _depot,
+    const std::vector<T>& _elements,
+    const ServiceTime& _serviceTime,
+    const Duration& _duration,
+    const std::shared_ptr<const double>& _durations,
+    bool euclidean
+)
+:
+_instance(std::make_shared<const Instance>(_depot, _elements, _serviceTime, _duration, _durations, euclidean)),
+_tour(_elements.size()),
+_depot(_depot),
+_elements(_elements)
+{
+    for (std::size_t j = 0UL; j < _tour.size(); j++)
+        _tour[j] = j + 1UL;
+
+    _cost = _totalCost();
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::basic_tsp(const std::shared_ptr<const Instance>& _instance, const std::vector<std::size_t>& _tour)
+:
+_instance(_instance),
+_tour(_tour),
+_depot(_instance->stops.front()),
+_elements()
+{
+    _elements.reserve(_tour.size());
+    for (const auto id : _tour)
+        _elements.push_back(_instance->stops[id]);
+
+    _cost = _totalCost();
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::basic_tsp(const basic_tsp& other)
+:
+_instance(other._instance),
+_tour(other._tour),
+_depot(other._depot),
+_elements(other._elements),
+_cost(other._cost)
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>::basic_tsp(basic_tsp&& other) noexcept
+:
+_instance(std::move(other._instance)),
+_tour(std::move(other._tour)),
+_depot(std::move(other._depot)),
+_elements(std::move(other._elements)),
+_cost(std::move(other._cost))
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>& basic_tsp<T, ServiceTime, Duration>::operator=(const basic_tsp& other)
+{
+    _instance = other._instance;
+    _tour     = other._tour;
+    _depot    = other._depot;
+    _elements = other._elements;
+    _cost     = other._cost;
+
+    return *this;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration>& basic_tsp<T, ServiceTime, Duration>::operator=(basic_tsp&& other) noexcept
+{
+    _instance = std::move(other._instance);
+    _tour     = std::move(other._tour);
+    _depot    = std::move(other._depot);
+    _elements = std::move(other._elements);
+    _cost     = std::move(other._cost);
+
+    return *this;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+std::ostream& operator<<(std::ostream& os, const basic_tsp<T, ServiceTime, Duration>& path)
+{
+    std::size_t id = 0UL;
+    for (const auto& element : path._elements)
+    {
+        os
+        << std::setw(3) << std::setfill('0') << ++id << ". "
+        << element << std::endl;
+    }
+
+    os << "\nCost: " << path.cost();
+
+    return os;
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::nneighbour() const
+{
+    INSTRUMENT(const Instrument::Scope scope("nneighbour");)
+
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    std::vector<std::size_t> tour;
+    tour.reserve(_tour.size());
+
+    // Once the matrix is no longer dense, scanning every remaining stop becomes prohibitive
+    if (_instance->tree && !matrix.dense())
+    {
+        // Only a few of the nearest stops, with respect to the euclidean distance,
+        // are ranked by their actual duration
+        const std::size_t K = 8UL;
+
+        KDTree tree(*_instance->tree);
+
+        std::vector<bool> visit(tree.size(), false);
+        for (const auto id : _tour)
+            visit[id] = true;
+
+        for (std::size_t id = 0UL; id < tree.size(); id++)
+            if (!visit[id])
+                tree.remove(id);
+
+        for (std::size_t current = 0UL; tree.alive() > 0UL; )
+        {
+            std::size_t nearest = tree.size();
+            double distance = std::numeric_limits<double>::infinity();
+
+            const std::vector<std::size_t> candidates(tree.nearest(tree.point(current), K));
+
+            for (const auto id : candidates)
+            {
+                const double d = matrix(current, id);
+
+                if (d < distance)
+                {
+                    distance = d; nearest = id;
+                }
+            }
+
+            // Every candidate duration is infinite or NaN; the nearest one is visited regardless
+            if (nearest == tree.size())
+                nearest = candidates.front();
+
+            tree.remove(nearest);
+
+            tour.push_back(current = nearest);
+        }
+
+        return basic_tsp(_instance, tour);
+    }
+
+    // The depot and the stops already visited are masked out
+    std::vector<std::uint8_t> visited(matrix.size(), 1U);
+    for (const auto id : _tour)
+        visited[id] = 0U;
+
+    for (std::size_t current = 0UL; tour.size() < _tour.size(); )
+    {
+        // The service time of the current stop is the same for every candidate
+        const double * row = matrix.row(current);
+
+        std::size_t nearest = matrix.size();
+
+        if (row)
+            nearest = Simd::argmin(row, visited.data(), matrix.size());
+        else
+        {
+            double distance = std::numeric_limits<double>::infinity();
+
+            for (std::size_t id = 0UL; id < matrix.size(); id++)
+            {
+                if (visited[id])
+                    continue;
+
+                const double d = matrix(current, id);
+
+                if (d < distance || nearest == matrix.size())
+                {
+                    distance = d; nearest = id;
+                }
+            }
+        }
+
+        // Every remaining duration is infinite
+        if (nearest == matrix.size())
+            nearest = static_cast<std::size_t>(std::find(visited.begin(), visited.end(), 0U) - visited.begin());
+
+        visited[nearest] = 1U;
+
+        tour.push_back(current = nearest);
+    }
+
+    return basic_tsp(_instance, tour);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::hilbert(std::size_t threads) const
+{
+    INSTRUMENT(const Instrument::Scope scope("hilbert");)
+
+    if (!_instance->tree)
+        return nneighbour();
+
+    const KDTree& tree = *_instance->tree;
+
+    // The depot is sorted along with the stops and the tour is rotated to start right after it
+    std::vector<std::size_t> ids; ids.reserve(_tour.size() + 1UL);
+
+    ids.push_back(0UL);
+    ids.insert(ids.end(), _tour.begin(), _tour.end());
+
+    std::vector<Vector2> positions; positions.reserve(ids.size());
+    for (const auto id : ids)
+        positions.push_back(tree.point(id));
+
+    const HilbertCurve curve(positions);
+
+    ThreadPool pool(threads > 1UL ? threads : 0UL);
+
+    std::vector<std::pair<std::uint64_t, std::size_t>> keys(ids.size());
+
+    const std::size_t chunks = std::max<std::size_t>(1UL, pool.size());
+
+    pool.parallel(chunks, [&](std::size_t c)
+    {
+        for (std::size_t i = ids.size() * c / chunks; i < ids.size() * (c + 1UL) / chunks; i++)
+            keys[i] = std::make_pair(curve(positions[i]), ids[i]);
+    });
+
+    pool.sort(keys.begin(), keys.end(), std::less<std::pair<std::uint64_t, std::size_t>>());
+
+    const std::size_t depot = static_cast<std::size_t>
+    (
+        std::find_if(keys.begin(), keys.end(), [](const auto& key) { return key.second == 0UL; }) - keys.begin()
+    );
+
+    std::vector<std::size_t> tour; tour.reserve(_tour.size());
+
+    for (std::size_t i = 1UL; i < keys.size(); i++)
+        tour.push_back(keys[(depot + i) % keys.size()].second);
+
+    return basic_tsp(_instance, tour);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::greedy(std::size_t threads) const
+{
+    INSTRUMENT(const Instrument::Scope scope("greedy");)
+
+    if (_tour.size() < 3UL)
+        return *this;
+
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    const std::size_t size = matrix.size(), none = size;
+
+    std::vector<std::uint8_t> member(size, 0U);
+
+    member[0UL] = 1U;
+    for (const auto id : _tour)
+        member[id] = 1U;
+
+    const Neighbours neighbours(_neighbours(10UL, threads));
+
+    // Every edge appears once per endpoint listing the other as a candidate;
+    // the second appearance is rejected for closing a cycle
+    struct Edge
+    {
+        double duration;
+
+        std::size_t i, j;
+    };
+
+    std::vector<Edge> edges; edges.reserve(size * neighbours.k());
+
+    for (std::size_t i = 0UL; i < size; i++)
+    {
+        if (!member[i])
+            continue;
+
+        for (std::size_t r = 0UL; r < neighbours.k(); r++)
+            if (member[neighbours.id(i, r)])
+                edges.push_back(Edge{ neighbours.distance(i, r), i, neighbours.id(i, r) });
+    }
+
+    ThreadPool pool(threads > 1UL ? threads : 0UL);
+
+    pool.sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b)
+    {
+        return a.duration < b.duration || (a.duration == b.duration && (a.i < b.i || (a.i == b.i && a.j < b.j)));
+    });
+
+    // The fragments are paths; every stop has up to two links
+    std::vector<std::size_t> link(2UL * size, none), degree(size, 0UL), parent(size);
+
+    for (std::size_t i = 0UL; i < size; i++)
+        parent[i] = i;
+
+    auto root = [&parent](std::size_t i)
+    {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+
+        return i;
+    };
+
+    for (const auto& edge : edges)
+    {
+        if (degree[edge.i] > 1UL || degree[edge.j] > 1UL)
+            continue;
+
+        const std::size_t a = root(edge.i), b = root(edge.j);
+
+        if (a == b)
+            continue;
+
+        parent[a] = b;
+
+        link[2UL * edge.i + degree[edge.i]++] = edge.j;
+        link[2UL * edge.j + degree[edge.j]++] = edge.i;
+    }
+
+    // The tour departs from the depot, which is hence made an endpoint of its fragment
+    if (degree[0UL] == 2UL)
+    {
+        const std::size_t b = link[1UL];
+
+        link[1UL] = none; degree[0UL]--;
+
+        std::size_t * slot = &link[2UL * b];
+        if (*slot != 0UL)
+            slot++;
+
+        *slot = link[2UL * b + 1UL]; link[2UL * b + 1UL] = none; degree[b]--;
+    }
+
+    // The endpoints of the fragments not yet appended to the tour
+    std::vector<std::uint8_t> visited(size, 0U);
+
+    std::vector<std::size_t> endpoints;
+
+    std::unique_ptr<KDTree> tree;
+
+    if (_instance->tree)
+    {
+        tree.reset(new KDTree(*_instance->tree));
+
+        for (std::size_t id = 0UL; id < size; id++)
+            if (!member[id] || degree[id] > 1UL)
+                tree->remove(id);
+    }
+    else
+    {
+        for (std::size_t id = 0UL; id < size; id++)
+            if (member[id] && degree[id] < 2UL)
+                endpoints.push_back(id);
+    }
+
+    auto retire = [&tree](std::size_t id)
+    {
+        if (tree && !tree->removed(id))
+            tree->remove(id);
+    };
+
+    // The endpoint of an unvisited fragment nearest to the specified stop
+    auto nearest = [&](std::size_t current)
+    {
+        std::size_t best = none;
+        double distance = std::numeric_limits<double>::infinity();
+
+        auto offer = [&](std::size_t id)
+        {
+            const double d = matrix(current, id);
+
+            if (d < distance || best == none)
+            {
+                distance = d; best = id;
+            }
+        };
+
+        if (tree)
+        {
+            for (const auto id : tree->nearest(tree->point(current), 8UL))
+                offer(id);
+
+            return best;
+        }
+
+        // Endpoints of visited fragments are dropped lazily
+        std::size_t kept = 0UL;
+        for (const auto id : endpoints)
+        {
+            if (visited[id])
+                continue;
+
+            endpoints[kept++] = id;
+
+            offer(id);
+        }
+
+        endpoints.resize(kept);
+
+        return best;
+    };
+
+    std::vector<std::size_t> tour; tour.reserve(_tour.size());
+
+    for (std::size_t current = 0UL; current != none; current = nearest(current))
+    {
+        // Walking the fragment from the current endpoint to the other one
+        for (std::size_t previous = none; ; )
+        {
+            visited[current] = 1U;
+
+            if (degree[current] < 2UL)
+                retire(current);
+
+            if (current != 0UL)
+                tour.push_back(current);
+
+            std::size_t next = link[2UL * current];
+            if (next == previous || next == none)
+                next = link[2UL * current + 1UL];
+
+            if (next == none || next == previous)
+                break;
+
+            previous = current; current = next;
+        }
+    }
+
+    return basic_tsp(_instance, tour);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+template <typename Search>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::_improve(const Search& search, const LocalSearch::Options& options, std::size_t threads) const
+{
+    if (_tour.size() < 3UL)
+        return *this;
+
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix(i, j);
+    };
+
+    std::vector<std::size_t> ids; ids.reserve(_tour.size() + 1UL);
+
+    ids.push_back(0UL);
+    ids.insert(ids.end(), _tour.begin(), _tour.end());
+
+    const Neighbours neighbours(_neighbours(options.neighbours, threads));
+
+    // Past the threshold, reversals are cheaper on a two-level list
+    if (ids.size() < TwoLevelTour::threshold)
+    {
+        ArrayTour tour(ids);
+
+        search(tour, distance, neighbours, options);
+
+        ids = tour.order(0UL);
+    }
+    else
+    {
+        TwoLevelTour tour(ids);
+
+        search(tour, distance, neighbours, options);
+
+        ids = tour.order(0UL);
+    }
+
+    return basic_tsp(_instance, std::vector<std::size_t>(ids.begin() + 1, ids.end()));
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::opt2(const LocalSearch::Options& options) const
+{
+    return _improve
+    (
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            return LocalSearch::opt2(tour, distance, neighbours, options);
+        },
+        options
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::oropt(const LocalSearch::Options& options) const
+{
+    return _improve
+    (
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            return LocalSearch::oropt(tour, distance, neighbours, options);
+        },
+        options
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::or3opt(const LocalSearch::Options& options) const
+{
+    return _improve
+    (
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            return LocalSearch::or3opt(tour, distance, neighbours, options);
+        },
+        options
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::linkernighan(const LocalSearch::Options& options) const
+{
+    return _improve
+    (
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            return LocalSearch::linkernighan(tour, distance, neighbours, options);
+        },
+        options
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::sannealing(const Annealing::Parallel& parallel, const Control& control) const
+{
+    return sannealing(Annealing::Schedule(), parallel, control);
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::sannealing
+(
+    const Annealing::Schedule& schedule,
+    const Annealing::Parallel& parallel,
+    const Control& control
+) const
+{
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix(i, j);
+    };
+
+    std::vector<std::size_t> route; route.reserve(_tour.size() + 1UL);
+
+    route.push_back(0UL);
+    route.insert(route.end(), _tour.begin(), _tour.end());
+
+    const Neighbours neighbours(_neighbours(10UL));
+
+    const std::size_t iterations = 1000000UL;
+
+    // Past the threshold, the moves are performed on a two-level list
+    if (route.size() < TwoLevelTour::threshold)
+    {
+        Moves<decltype(distance)> moves(distance, route, _cost, Moves<decltype(distance)>::All, &neighbours);
+
+        Annealing::simulated(moves, schedule, iterations, parallel, control);
+
+        route = moves.route();
+    }
+    else
+    {
+        using Large = TourMoves<TwoLevelTour, decltype(distance)>;
+
+        Large moves(distance, route, _cost, Large::All, &neighbours);
+
+        Annealing::simulated(moves, schedule, iterations, parallel, control);
+
+        route = moves.route();
+    }
+
+    return basic_tsp(_instance, std::vector<std::size_t>(route.begin() + 1, route.end()));
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::memetic(const Memetic::Options& options, const Control& control) const
+{
+    if (_tour.size() < 3UL)
+        return *this;
+
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix(i, j);
+    };
+
+    std::vector<std::size_t> route; route.reserve(_tour.size() + 1UL);
+
+    route.push_back(0UL);
+    route.insert(route.end(), _tour.begin(), _tour.end());
+
+    const Neighbours neighbours(_neighbours(10UL, options.threads));
+
+    auto evaluate = [this](const std::vector<std::size_t>& route)
+    {
+        return Memetic::Fitness(0.0, basic_tsp(_instance, std::vector<std::size_t>(route.begin() + 1, route.end())).cost());
+    };
+
+    auto improve = [&distance, &neighbours, &control](std::vector<std::size_t>& route, const std::vector<std::size_t>& focus)
+    {
+        LocalSearch::Options local; local.cancel = control.cancel; local.focus = focus;
+
+        auto search = [&](auto& tour)
+        {
+            LocalSearch::opt2(tour, distance, neighbours, local);
+            LocalSearch::oropt(tour, distance, neighbours, local);
+
+            route = tour.order(0UL);
+        };
+
+        // Past the threshold, reversals are cheaper on a two-level list
+        if (route.size() < TwoLevelTour::threshold)
+        {
+            ArrayTour tour(route); search(tour);
+        }
+        else
+        {
+            TwoLevelTour tour(route); search(tour);
+        }
+    };
+
+    route = Memetic::evolve(route, distance, neighbours, evaluate, improve, false, options, control);
+
+    return basic_tsp(_instance, std::vector<std::size_t>(route.begin() + 1, route.end()));
+}
+
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::decompose(const Decomposition::Options& options) const
+{
+    if (_tour.size() < 3UL)
+        return *this;
+
+    if (!_instance->tree)
+        return linkernighan(options.search).oropt(options.search);
+
+    const Deadline deadline(options.search.seconds);
+
+    // The searches of the clusters run concurrently, hence report no progress
+    LocalSearch::Options search(options.search);
+
+    search.progress = nullptr;
+
+    const DistanceMatrix& matrix = _instance->matrix;
+
+    const KDTree& tree = *_instance->tree;
+
+    std::vector<std::size_t> ids; ids.reserve(_tour.size() + 1UL);
+
+    ids.push_back(0UL);
+    ids.insert(ids.end(), _tour.begin(), _tour.end());
+
+    std::vector<Vector2> positions; positions.reserve(ids.size());
+    for (const auto id : ids)
+        positions.push_back(tree.point(id));
+
+    std::vector<std::vector<std::size_t>> clusters(Decomposition::partition(positions, options));
+
+    for (auto& cluster : clusters)
+        for (auto& id : cluster)
+            id = ids[id];
+
+    // Every cluster is replaced by a cycle through its stops
+    ThreadPool pool(options.threads > 1UL ? options.threads : 0UL);
+
+    pool.parallel(clusters.size(), [&matrix, &tree, &clusters, &search, &deadline](std::size_t c)
+    {
+        std::vector<std::size_t>& cluster = clusters[c];
+
+        if (cluster.size() < 4UL || deadline.expired() || search.cancel.cancelled())
+            return;
+
+        // Whatever remains of the budget
+        LocalSearch::Options remaining(search);
+
+        remaining.seconds = search.seconds - deadline.elapsed();
+
+        const std::vector<std::size_t> members(cluster);
+
+        auto distance = [&matrix, &members](std::size_t i, std::size_t j)
+        {
+            return matrix(members[i], members[j]);
+        };
+
+        std::vector<Vector2> points; points.reserve(members.size());
+        for (const auto id : members)
+            points.push_back(tree.point(id));
+
+        const Neighbours neighbours(KDTree(points), remaining.neighbours, distance);
+
+        // The members are already ordered along a Hilbert curve
+        std::vector<std::size_t> order(members.size());
+        for (std::size_t i = 0UL; i < order.size(); i++)
+            order[i] = i;
+
+        ArrayTour tour(order);
+
+        LocalSearch::linkernighan(tour, distance, neighbours, remaining);
+        LocalSearch::oropt(tour, distance, neighbours, remaining);
+
+        order = tour.order(0UL);
+
+        for (std::size_t i = 0UL; i < order.size(); i++)
+            cluster[i] = members[order[i]];
+    });
+
+    auto centroid = [&tree](const std::vector<std::size_t>& cluster)
+    {
+        double x = 0.0, y = 0.0;
+        for (const auto id : cluster)
+        {
+            x += tree.point(id).x(); y += tree.point(id).y();
+        }
+
+        return Vector2(x / cluster.size(), y / cluster.size());
+    };
+
+    // Every cycle is entered at its stop nearest to the last one visited
+    // and left by whichever neighbour of the entry lies closer to the next cluster
+    std::vector<std::size_t> tour; tour.reserve(ids.size());
+
+    for (std::size_t c = 0UL; c < clusters.size(); c++)
+    {
+        const std::vector<std::size_t>& cycle = clusters[c];
+
+        const std::size_t m = cycle.size();
+
+        std::size_t entry = 0UL;
+
+        if (!tour.empty())
+        {
+            double distance = std::numeric_limits<double>::infinity();
+
+            for (std::size_t p = 0UL; p < m; p++)
+            {
+                const double d = matrix(tour.back(), cycle[p]);
+
+                if (d < distance)
+                {
+                    distance = d; entry = p;
+                }
+            }
+        }
+
+        const Vector2 target = c + 1UL < clusters.size() ? centroid(clusters[c + 1UL]) : tree.point(tour.empty() ? cycle[entry] : tour.front());
+
+        auto squared = [&tree, &target](std::size_t id)
+        {
+            const double dx = tree.point(id).x() - target.x(), dy = tree.point(id).y() - target.y();
+
+            return dx * dx + dy * dy;
+        };
+
+        const bool forward = squared(cycle[(entry + m - 1UL) % m]) <= squared(cycle[(entry + 1UL) % m]);
+
+        for (std::size_t i = 0UL; i < m; i++)
+            tour.push_back(cycle[forward ? (entry + i) % m : (entry + m - i) % m]);
+    }
+
+    const std::size_t depot = static_cast<std::size_t>(std::find(tour.begin(), tour.end(), 0UL) - tour.begin());
+
+    std::vector<std::size_t> route; route.reserve(_tour.size());
 
-    for (std::size_t j = 0; j < _elements.size() - 1UL; j++)
-        _cost += _partialCost(_elements[j], _elements[j + 1UL]);
+    for (std::size_t i = 1UL; i < tour.size(); i++)
+        route.push_back(tour[(depot + i) % tour.size()]);
 
-    _cost += _partialCost(_elements.back(), _depot);
+    // Repairing the seams
+    LocalSearch::Options repair(options.search);
 
-    return _cost;
-}
+    repair.seconds = std::max(0.0, options.search.seconds - deadline.elapsed());
 
-template <typename T>
-tsp<T>::tsp()
-:
-_depot(),
-_elements(),
-_serviceTime([](const T& t) { return std::numeric_limits<double>().max(); }),
-_duration([](const T& A, const T& B) { return std::numeric_limits<double>().max(); }),
-_cost(std::numeric_limits<double>().max())
-{
+    return basic_tsp(_instance, route)._improve
+    (
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            LocalSearch::opt2(tour, distance, neighbours, options);
+            LocalSearch::oropt(tour, distance, neighbours, options);
+        },
+        repair,
+        options.threads
+    );
 }
 
-template <typename T>
-tsp<T>::tsp
-(
-    const T& _depot,
-    const std::vector<T>& _elements,
-    const std::function<double(const T&)>& _serviceTime,
-    const std::function<double(const T&, const T&)>& _duration
-)
-:
-_depot(_depot),
-_elements(_elements),
-_serviceTime(_serviceTime),
-_duration(_duration),
-_cost(_totalCost())
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::insert(const T& stop, const LocalSearch::Options& options) const
 {
-    if (std::find(_elements.begin(), _elements.end(), _depot) != _elements.end())
-        throw std::invalid_argument("depot amongst the elements");
-}
+    if (stop == _depot || _find(stop) != 0UL)
+        throw std::invalid_argument("stop already amongst the elements");
 
-template <typename T>
-tsp<T>::tsp(const tsp<T>& other)
-:
-_depot(other._depot),
-_elements(other._elements),
-_serviceTime(other._serviceTime),
-_duration(other._duration),
-_cost(other._cost)
-{
-}
+    const std::size_t n = _instance->stops.size();
 
-template <typename T>
-tsp<T>::tsp(tsp<T>&& other) noexcept
-:
-_depot(std::move(other._depot)),
-_elements(std::move(other._elements)),
-_serviceTime(std::move(other._serviceTime)),
-_duration(std::move(other._duration)),
-_cost(std::move(other._cost))
-{
-}
+    std::vector<std::size_t> kept(n);
+    for (std::size_t id = 0UL; id < n; id++)
+        kept[id] = id;
 
-template <typename T>
-tsp<T>& tsp<T>::operator=(const tsp<T>& other)
-{
-    _depot       = other._depot;
-    _elements    = other._elements;
-    _serviceTime = other._serviceTime;
-    _duration    = other._duration;
-    _cost        = other._cost;
+    const auto instance = std::make_shared<const Instance>(_instance, kept, std::vector<T>(1UL, stop));
 
-    return *this;
-}
+    const DistanceMatrix& matrix = instance->matrix;
 
-template <typename T>
-tsp<T>& tsp<T>::operator=(tsp<T>&& other) noexcept
-{
-    _depot       = std::move(other._depot);
-    _elements    = std::move(other._elements);
-    _serviceTime = std::move(other._serviceTime);
-    _duration    = std::move(other._duration);
-    _cost        = std::move(other._cost);
+    std::vector<std::size_t> route; route.reserve(n + 1UL);
 
-    return *this;
-}
+    route.push_back(0UL);
+    route.insert(route.end(), _tour.begin(), _tour.end());
 
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const tsp<T>& path)
-{
-    std::size_t id = 0UL;
-    for (const auto& element : path._elements)
+    // The stop is inserted between the positions p and p + 1 of the route
+    std::size_t best = 0UL; double bdelta = std::numeric_limits<double>::infinity();
+
+    auto consider = [&matrix, &route, &best, &bdelta, n](std::size_t p)
     {
-        os
-        << std::setw(3) << std::setfill('0') << ++id << ". "
-        << element << std::endl;
-    }
-    
-    os << "\nCost: " << path.cost();
+        const std::size_t a = route[p], b = route[(p + 1UL) % n];
 
-    return os;
-}
+        const double delta = matrix(a, n) + matrix(n, b) - matrix(a, b);
 
-template <typename T>
-tsp<T> tsp<T>::nneighbour() const
-{
-    std::vector<T> oelements(this->_elements), nelements;
+        if (delta < bdelta)
+        {
+            bdelta = delta; best = p;
+        }
+    };
 
-    auto nearestTo = [&oelements, this](const T& current)
+    // Only the edges incident to the nearest stops are considered, if possible
+    if (instance->tree)
     {
-        auto it = std::min_element
-        (
-            oelements.begin(),
-            oelements.end(),
-            [&current, this](const T& A, const T& B)
-            {
-                return this->_partialCost(current, A) < this->_partialCost(current, B);
-            }
-        );
+        std::vector<std::size_t> position(n);
+        for (std::size_t p = 0UL; p < n; p++)
+            position[route[p]] = p;
 
-        T nearest(*it); oelements.erase(it); return nearest;
-    };
+        const KDTree& tree = *instance->tree;
+
+        for (const auto id : tree.nearest(tree.point(n), std::max<std::size_t>(options.neighbours, 1UL), n))
+        {
+            consider(position[id]); consider((position[id] + n - 1UL) % n);
+        }
+    }
+    else
+    {
+        for (std::size_t p = 0UL; p < n; p++)
+            consider(p);
+    }
+
+    LocalSearch::Options focused(options);
+
+    focused.focus = { route[best], n, route[(best + 1UL) % n] };
 
-    nelements.emplace_back(nearestTo(this->_depot));
-    while (!oelements.empty())
-        nelements.emplace_back(nearestTo(nelements.back()));
+    route.insert(route.begin() + best + 1UL, n);
 
-    return tsp<T>(this->_depot, nelements, this->_serviceTime, this->_duration);
+    return basic_tsp(instance, std::vector<std::size_t>(route.begin() + 1, route.end()))._improve
+    (
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            LocalSearch::opt2(tour, distance, neighbours, options);
+            LocalSearch::oropt(tour, distance, neighbours, options);
+        },
+        focused
+    );
 }
 
-template <typename T>
-tsp<T> tsp<T>::opt2() const
+template <typename T, typename ServiceTime, typename Duration>
+basic_tsp<T, ServiceTime, Duration> basic_tsp<T, ServiceTime, Duration>::remove(const T& stop, const LocalSearch::Options& options) const
 {
-    tsp<T> best(*this);
+    const std::size_t r = _find(stop);
 
-    auto opt2swap = [&best](std::size_t i, std::size_t k)
-    {
-        // 1. take route[0] to route[i-1] and add them in order to new_route
-        // 2. take route[i] to route[k] and add them in reverse order to new_route
-        // 3. take route[k+1] to end and add them in order to new_route
+    if (r == 0UL)
+        throw std::invalid_argument("stop not amongst the elements");
 
-        std::vector<T> next(best._elements);
+    const std::size_t last = _instance->stops.size() - 1UL;
 
-        std::reverse(next.begin() + i, next.begin() + k);
+    // The last id takes the place of the removed one, hence the rest keep theirs
+    std::vector<std::size_t> kept(last);
+    for (std::size_t id = 0UL; id < last; id++)
+        kept[id] = id == r ? last : id;
 
-        return tsp<T>(best._depot, next, best._serviceTime, best._duration);
-    };
+    const auto instance = std::make_shared<const Instance>(_instance, kept, std::vector<T>());
 
-    for (std::size_t i = 0; i < best._elements.size() - 1; i++)
-    {
-        for (std::size_t k = i + 1UL; k < best._elements.size(); k++)
-        {
-            const tsp<T> neighbour(opt2swap(i, k));
+    auto remap = [r, last](std::size_t id) { return id == last ? r : id; };
 
-            if (neighbour._cost < best._cost)
-                return neighbour.opt2();
-        }
-    }
+    std::vector<std::size_t> tour; tour.reserve(_tour.size() - 1UL);
 
-    return best;
-}
+    LocalSearch::Options focused(options);
 
-template <typename T>
-tsp<T> tsp<T>::sannealing() const
-{
-    auto randomSwap = [](const tsp<T>& current)
+    for (std::size_t j = 0UL; j < _tour.size(); j++)
     {
-        std::vector<T> next(current._elements);
-
-        const std::size_t i = std::rand() % next.size();
-        const std::size_t j = std::rand() % next.size();
-
-        const T element(next[i]);
-        next[i] = next[j];
-        next[j] = element;
+        if (_tour[j] != r)
+        {
+            tour.push_back(remap(_tour[j]));
 
-        return tsp(current._depot, next, current._serviceTime, current._duration);
-    };
+            continue;
+        }
 
-    const double temperature = 100000.0, cooling = 0.000005;
-    const std::size_t iterations = 1000000UL;
+        // The stops around the gap
+        focused.focus =
+        {
+            j > 0UL ? remap(_tour[j - 1UL]) : 0UL,
+            j + 1UL < _tour.size() ? remap(_tour[j + 1UL]) : 0UL
+        };
+    }
 
-    return Annealing::simulated<tsp<T>>
+    return basic_tsp(instance, tour)._improve
     (
-        *this,
-        randomSwap,
-        [](const tsp<T>& path) { return path._cost; },
-        temperature,
-        cooling,
-        iterations
+        [](auto& tour, const auto& distance, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            LocalSearch::opt2(tour, distance, neighbours, options);
+            LocalSearch::oropt(tour, distance, neighbours, options);
+        },
+        focused
     );
 }
 
-// Class tsptw:
-template <typename T>
-double tsptw<T>::_partialPenalty(double& arrivalTime, const T& A, const T& B) const
+// Class basic_tsptw:
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> make_tsptw
+(
+    const T& depot,
+    const std::vector<T>& elements,
+    const ServiceTime& serviceTime,
+    const Duration& duration,
+    double departureTime,
+    const Window& timewindow,
+    bool euclidean
+)
 {
-    arrivalTime += this->_partialCost(A, B);
+    return basic_tsptw<T, ServiceTime, Duration, Window>(depot, elements, serviceTime, duration, departureTime, timewindow, euclidean);
+}
 
-    const double startOfService = std::max<double>
-    (
-        arrivalTime,
-        this->_timewindow(B).first
-    );
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+double basic_tsptw<T, ServiceTime, Duration, Window>::_partialPenalty(double& arrivalTime, std::size_t i, std::size_t j) const
+{
+    arrivalTime += this->_partialCost(i, j);
+
+    const Timewindow& window = _timewindows->windows[j];
+
+    const double startOfService = std::max<double>(arrivalTime, window.first);
 
     return std::max<double>
     (
         0.0,
-        startOfService + this->_serviceTime(B) - this->_timewindow(B).second
+        startOfService + this->_instance->service[j] - window.second
     );
 }
 
-template <typename T>
-double tsptw<T>::_totalPenalty() const
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+double basic_tsptw<T, ServiceTime, Duration, Window>::_totalPenalty() const
 {
+    if (this->_tour.empty())
+        return 0.0;
+
     double arrivalTime = _departureTime, _penalty;
-    
-    _penalty = _partialPenalty(arrivalTime, this->_depot, this->_elements.front());
-    
-    for (std::size_t j = 0; j < this->_elements.size() - 1UL; j++)
-        _penalty += _partialPenalty(arrivalTime, this->_elements[j], this->_elements[j + 1UL]);
 
-    _penalty += _partialPenalty(arrivalTime, this->_elements.back(), this->_depot);
+    _penalty = _partialPenalty(arrivalTime, 0UL, this->_tour.front());
+
+    for (std::size_t j = 0; j < this->_tour.size() - 1UL; j++)
+        _penalty += _partialPenalty(arrivalTime, this->_tour[j], this->_tour[j + 1UL]);
+
+    _penalty += _partialPenalty(arrivalTime, this->_tour.back(), 0UL);
 
     return _penalty;
 }
 
-template <typename T>
-tsptw<T>::tsptw()
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+std::shared_ptr<const typename basic_tsptw<T, ServiceTime, Duration, Window>::Timewindows>
+basic_tsptw<T, ServiceTime, Duration, Window>::_mapTimewindows(const Window& function) const
+{
+    auto _timewindows = std::make_shared<Timewindows>(function);
+
+    _timewindows->windows.reserve(this->_instance->stops.size());
+    for (const auto& stop : this->_instance->stops)
+        _timewindows->windows.push_back(function(stop));
+
+    return _timewindows;
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+std::shared_ptr<const typename basic_tsptw<T, ServiceTime, Duration, Window>::Timewindows>
+basic_tsptw<T, ServiceTime, Duration, Window>::_mapTimewindows(const std::vector<std::size_t>& kept, const std::vector<T>& stops) const
+{
+    auto _timewindows = std::make_shared<Timewindows>(this->_timewindows->function);
+
+    _timewindows->windows.reserve(stops.size());
+    for (const auto id : kept)
+        _timewindows->windows.push_back(this->_timewindows->windows[id]);
+
+    for (std::size_t id = kept.size(); id < stops.size(); id++)
+        _timewindows->windows.push_back(_timewindows->function(stops[id]));
+
+    return _timewindows;
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw()
 :
-tsp<T>(),
+base(),
 _departureTime(0.0),
-_timewindow([](const T& t) { return std::make_pair(0.0, 0.0); }),
+_timewindows(_mapTimewindows(Window())),
 _penalty(std::numeric_limits<double>().max())
 {
 }
 
-template <typename T>
-tsptw<T>::tsptw
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw
+(
+    const T& _depot,
+    const std::vector<T>& _elements,
+    const ServiceTime& _serviceTime,
+    const Duration& _duration,
+    double _departureTime,
+    const Window& _timewindow,
+    bool euclidean
+)
+:
+base(_depot, _elements, _serviceTime, _duration, euclidean),
+_departureTime(_departureTime),
+_timewindows(_mapTimewindows(_timewindow)),
+_penalty(_totalPenalty())
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw
 (
     const T& _depot,
     const std::vector<T>& _elements,
-    const std::function<double(const T&)>& _serviceTime,
-    const std::function<double(const T&, const T&)>& _duration,
+    const ServiceTime& _serviceTime,
+    const Duration& _duration,
     double _departureTime,
-    const std::function<tsptw::Timewindow(const T&)>& _timewindow
+    const Window& _timewindow,
+    const std::shared_ptr<const double>& _durations,
+    bool euclidean
 )
 :
-tsp<T>(_depot, _elements, _serviceTime, _duration),
+base(_depot, _elements, _serviceTime, _duration, _durations, euclidean),
 _departureTime(_departureTime),
-_timewindow(_timewindow),
+_timewindows(_mapTimewindows(_timewindow)),
+_penalty(_totalPenalty())
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw(const basic_tsptw& prototype, const std::vector<std::size_t>& _tour)
+:
+base(prototype._instance, _tour),
+_departureTime(prototype._departureTime),
+_timewindows(prototype._timewindows),
+_penalty(_totalPenalty())
+{
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw
+(
+    const basic_tsptw& prototype,
+    const std::shared_ptr<const typename base::Instance>& _instance,
+    const std::shared_ptr<const Timewindows>& _timewindows,
+    const std::vector<std::size_t>& _tour
+)
+:
+base(_instance, _tour),
+_departureTime(prototype._departureTime),
+_timewindows(_timewindows),
 _penalty(_totalPenalty())
 {
 }
 
-template <typename T>
-tsptw<T>::tsptw(const tsptw<T>& other)
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw(const basic_tsptw& other)
 :
-tsp<T>(other),
+base(other),
 _departureTime(other._departureTime),
-_timewindow(other._timewindow),
+_timewindows(other._timewindows),
 _penalty(other._penalty)
 {
 }
 
-template <typename T>
-tsptw<T>::tsptw(tsptw<T>&& other) noexcept
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>::basic_tsptw(basic_tsptw&& other) noexcept
 :
-tsp<T>(std::move(other)),
+base(std::move(other)),
 _departureTime(std::move(other._departureTime)),
-_timewindow(std::move(other._timewindow)),
+_timewindows(std::move(other._timewindows)),
 _penalty(std::move(other._penalty))
 {
 }
 
-template <typename T>
-tsptw<T>& tsptw<T>::operator=(const tsptw<T>& other)
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>& basic_tsptw<T, ServiceTime, Duration, Window>::operator=(const basic_tsptw& other)
 {
-    tsp<T>::operator=(other);
+    base::operator=(other);
 
     _departureTime = other._departureTime;
-    _timewindow    = other._timewindow;
+    _timewindows   = other._timewindows;
     _penalty       = other._penalty;
 
     return *this;
 }
 
-template <typename T>
-tsptw<T>& tsptw<T>::operator=(tsptw<T>&& other) noexcept
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>& basic_tsptw<T, ServiceTime, Duration, Window>::operator=(basic_tsptw&& other) noexcept
 {
-    tsp<T>::operator=(std::move(other));
-    
+    base::operator=(std::move(other));
+
     _departureTime = std::move(other._departureTime);
-    _timewindow    = std::move(other._timewindow);
+    _timewindows   = std::move(other._timewindows);
     _penalty       = std::move(other._penalty);
 
     return *this;
 }
 
-template <typename T>
-tsptw<T>& tsptw<T>::operator=(const tsp<T>& other)
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>& basic_tsptw<T, ServiceTime, Duration, Window>::operator=(const base& other)
 {
-    tsp<T>::operator=(other);
+    const bool remap = !this->_shares(other);
+
+    base::operator=(other);
+
+    // The timewindows are indexed by the ids of a different instance
+    if (remap)
+        _timewindows = _mapTimewindows(_timewindows->function);
 
     _penalty = _totalPenalty();
 
     return *this;
 }
 
-template <typename T>
-tsptw<T>& tsptw<T>::operator=(tsp<T>&& other) noexcept
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window>& basic_tsptw<T, ServiceTime, Duration, Window>::operator=(base&& other) noexcept
 {
-    tsp<T>::operator=(std::move(other));
+    const bool remap = !this->_shares(other);
+
+    base::operator=(std::move(other));
+
+    if (remap)
+        _timewindows = _mapTimewindows(_timewindows->function);
 
     _penalty = _totalPenalty();
 
     return *this;
 }
 
-template <typename T>
-std::ostream& operator<<(std::ostream& os, const tsptw<T>& path)
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+std::ostream& operator<<(std::ostream& os, const basic_tsptw<T, ServiceTime, Duration, Window>& path)
 {
-    os << static_cast<tsp<T>>(path) << " Penalty: " << path._penalty;
+    os << static_cast<const basic_tsp<T, ServiceTime, Duration>&>(path) << " Penalty: " << path._penalty;
 
     return os;
 }
 
-template <typename T>
-tsptw<T> tsptw<T>::cannealing() const
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+template <typename Search>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::_improve(const Search& search, const LocalSearch::Options& options) const
 {
-    auto shift1 = [](const tsptw<T>& current)
+    if (this->_tour.size() < 2UL)
+        return *this;
+
+    const DistanceMatrix& matrix = this->_instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
     {
-        std::vector<T> next(current._elements);
+        return matrix(i, j);
+    };
 
-        const std::size_t i = std::rand() % next.size();
-        const std::size_t j = std::rand() % next.size();
+    std::vector<std::size_t> route; route.reserve(this->_tour.size() + 1UL);
 
-        const T element(next[i]);
-        next.erase(next.begin() + i);
-        next.insert(next.begin() + j, element);
+    route.push_back(0UL);
+    route.insert(route.end(), this->_tour.begin(), this->_tour.end());
 
-        return tsptw<T>
-        (
-            current._depot,
-            next,
-            current._serviceTime,
-            current._duration,
-            current._departureTime,
-            current._timewindow
-        );
+    WindowedMoves<decltype(distance)> moves
+    (
+        distance,
+        this->_instance->service,
+        _timewindows->windows,
+        _departureTime,
+        route
+    );
+
+    search(moves, this->_neighbours(options.neighbours), options);
+
+    route = moves.route();
+
+    return basic_tsptw(*this, std::vector<std::size_t>(route.begin() + 1, route.end()));
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::oropt(const LocalSearch::Options& options) const
+{
+    return _improve
+    (
+        [](auto& moves, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            return LocalSearch::oropt(moves, neighbours, options);
+        },
+        options
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::or3opt(const LocalSearch::Options& options) const
+{
+    return _improve
+    (
+        [](auto& moves, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            return LocalSearch::or3opt(moves, neighbours, options);
+        },
+        options
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::cannealing(const Annealing::Parallel& parallel, const Control& control) const
+{
+    Annealing::Calibration calibration;
+
+    return cannealing(calibration, parallel, control);
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::cannealing
+(
+    Annealing::Calibration& calibration,
+    const Annealing::Parallel& parallel,
+    const Control& control
+) const
+{
+    const DistanceMatrix& matrix = this->_instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix(i, j);
     };
 
+    std::vector<std::size_t> route; route.reserve(this->_tour.size() + 1UL);
+
+    route.push_back(0UL);
+    route.insert(route.end(), this->_tour.begin(), this->_tour.end());
+
+    WindowedMoves<decltype(distance)> moves
+    (
+        distance,
+        this->_instance->service,
+        _timewindows->windows,
+        _departureTime,
+        route
+    );
+
     // Parameter Initialization (Robust Set provided by the authors):
     const double COOLING    = 0.95,    // (1)  Cooling Coefficient
                 ACCEPTANCE  = 0.94,    // (2)  Initial Acceptance Ratio
@@ -385,14 +1583,9 @@ tsptw<T> tsptw<T>::cannealing() const
                     TLI   = IPT,        // (9)  Trial loop of iterations
                     TNP   = 5000UL;     // (10) Trial neighbour pairs
 
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
-
-    return Annealing::compressed<tsptw<T>>
+    calibration = Annealing::compressed
     (
-        *this,
-        shift1,
-        [](const tsptw<T>& path) { return path._cost; },
-        [](const tsptw<T>& path) { return path._penalty; },
+        moves,
         COOLING,
         ACCEPTANCE,
         PRESSURE0,
@@ -402,6 +1595,199 @@ tsptw<T> tsptw<T>::cannealing() const
         MTC,
         ITC,
         TLI,
-        TNP
+        TNP,
+        parallel,
+        control,
+        calibration
+    );
+
+    route = moves.route();
+
+    return basic_tsptw(*this, std::vector<std::size_t>(route.begin() + 1, route.end()));
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::memetic(const Memetic::Options& options, const Control& control) const
+{
+    if (this->_tour.size() < 3UL)
+        return *this;
+
+    const DistanceMatrix& matrix = this->_instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix(i, j);
+    };
+
+    std::vector<std::size_t> route; route.reserve(this->_tour.size() + 1UL);
+
+    route.push_back(0UL);
+    route.insert(route.end(), this->_tour.begin(), this->_tour.end());
+
+    const Neighbours neighbours(this->_neighbours(10UL, options.threads));
+
+    auto evaluate = [this](const std::vector<std::size_t>& route)
+    {
+        const basic_tsptw child(*this, std::vector<std::size_t>(route.begin() + 1, route.end()));
+
+        return Memetic::Fitness(child.penalty(), child.cost());
+    };
+
+    auto improve = [this, &distance, &neighbours, &control](std::vector<std::size_t>& route, const std::vector<std::size_t>& focus)
+    {
+        LocalSearch::Options local; local.cancel = control.cancel; local.focus = focus;
+
+        WindowedMoves<decltype(distance)> moves
+        (
+            distance,
+            this->_instance->service,
+            _timewindows->windows,
+            _departureTime,
+            route
+        );
+
+        LocalSearch::oropt(moves, neighbours, local);
+        LocalSearch::or3opt(moves, neighbours, local);
+
+        route = moves.route();
+    };
+
+    route = Memetic::evolve(route, distance, neighbours, evaluate, improve, true, options, control);
+
+    return basic_tsptw(*this, std::vector<std::size_t>(route.begin() + 1, route.end()));
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::insert(const T& stop, const LocalSearch::Options& options) const
+{
+    using Instance = typename base::Instance;
+
+    if (stop == this->_depot || this->_find(stop) != 0UL)
+        throw std::invalid_argument("stop already amongst the elements");
+
+    const std::size_t n = this->_instance->stops.size();
+
+    std::vector<std::size_t> kept(n);
+    for (std::size_t id = 0UL; id < n; id++)
+        kept[id] = id;
+
+    const auto instance = std::make_shared<const Instance>(this->_instance, kept, std::vector<T>(1UL, stop));
+
+    const auto timewindows = _mapTimewindows(kept, instance->stops);
+
+    // Without any element, the stop can only follow the depot
+    if (n == 1UL)
+        return basic_tsptw(*this, instance, timewindows, std::vector<std::size_t>(1UL, n));
+
+    const DistanceMatrix& matrix = instance->matrix;
+
+    auto distance = [&matrix](std::size_t i, std::size_t j)
+    {
+        return matrix(i, j);
+    };
+
+    std::vector<std::size_t> route; route.reserve(n + 1UL);
+
+    route.push_back(0UL);
+    route.insert(route.end(), this->_tour.begin(), this->_tour.end());
+
+    const WindowedMoves<decltype(distance)> moves
+    (
+        distance,
+        instance->service,
+        timewindows->windows,
+        _departureTime,
+        route
+    );
+
+    // The stop is inserted right after the position p of the route.
+    // As the timewindows may favour distant positions, every one is considered
+    std::size_t best = 0UL;
+
+    std::pair<double, double> bdelta
+    (
+        std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::infinity()
+    );
+
+    for (std::size_t p = 0UL; p < n; p++)
+    {
+        const std::pair<double, double> delta = p == 0UL
+            ? moves.evaluate(1UL, 1UL, { n, route[1UL] })
+            : moves.evaluate(p, p, { route[p], n });
+
+        if (delta.second < bdelta.second || (delta.second == bdelta.second && delta.first < bdelta.first))
+        {
+            bdelta = delta; best = p;
+        }
+    }
+
+    LocalSearch::Options focused(options);
+
+    focused.focus = { route[best], n, route[(best + 1UL) % n] };
+
+    route.insert(route.begin() + best + 1UL, n);
+
+    return basic_tsptw(*this, instance, timewindows, std::vector<std::size_t>(route.begin() + 1, route.end()))._improve
+    (
+        [](auto& moves, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            LocalSearch::oropt(moves, neighbours, options);
+            LocalSearch::or3opt(moves, neighbours, options);
+        },
+        focused
+    );
+}
+
+template <typename T, typename ServiceTime, typename Duration, typename Window>
+basic_tsptw<T, ServiceTime, Duration, Window> basic_tsptw<T, ServiceTime, Duration, Window>::remove(const T& stop, const LocalSearch::Options& options) const
+{
+    using Instance = typename base::Instance;
+
+    const std::size_t r = this->_find(stop);
+
+    if (r == 0UL)
+        throw std::invalid_argument("stop not amongst the elements");
+
+    const std::size_t last = this->_instance->stops.size() - 1UL;
+
+    // The last id takes the place of the removed one, hence the rest keep theirs
+    std::vector<std::size_t> kept(last);
+    for (std::size_t id = 0UL; id < last; id++)
+        kept[id] = id == r ? last : id;
+
+    const auto instance = std::make_shared<const Instance>(this->_instance, kept, std::vector<T>());
+
+    auto remap = [r, last](std::size_t id) { return id == last ? r : id; };
+
+    std::vector<std::size_t> tour; tour.reserve(this->_tour.size() - 1UL);
+
+    LocalSearch::Options focused(options);
+
+    for (std::size_t j = 0UL; j < this->_tour.size(); j++)
+    {
+        if (this->_tour[j] != r)
+        {
+            tour.push_back(remap(this->_tour[j]));
+
+            continue;
+        }
+
+        // The stops around the gap
+        focused.focus =
+        {
+            j > 0UL ? remap(this->_tour[j - 1UL]) : 0UL,
+            j + 1UL < this->_tour.size() ? remap(this->_tour[j + 1UL]) : 0UL
+        };
+    }
+
+    return basic_tsptw(*this, instance, _mapTimewindows(kept, instance->stops), tour)._improve
+    (
+        [](auto& moves, const Neighbours& neighbours, const LocalSearch::Options& options)
+        {
+            LocalSearch::oropt(moves, neighbours, options);
+            LocalSearch::or3opt(moves, neighbours, options);
+        },
+        focused
     );
 }
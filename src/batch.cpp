@@ -0,0 +1,373 @@
+
+#include "tsp.hpp"
+#include "vector2.hpp"
+#include "kdtree.hpp"
+#include "binary.hpp"
+#include "stealingpool.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+// Solves a stream of independent instances concurrently.
+//
+// Usage: BATCH [FILE|-] [SECONDS] [THREADS]
+//
+// Every instance consists of a header line, either
+//     <name> TSP <n>
+//     <name> TSPTW <n> <departure>
+// followed by the depot and the n stops, one per line, either
+//     <x> <y>
+//     <x> <y> <service> <open> <close>
+// respectively. Blank lines and lines starting with '#' are skipped.
+// The duration between two stops is their euclidean distance.
+//
+// Alternatively, FILE may be a single instance converted by CONVERT (*.bin),
+// which is memory mapped and whose durations, if stored, are looked up in place,
+// and otherwise evaluated with the rounding recorded by CONVERT.
+//
+// A line is written as soon as every instance is solved:
+//     <name> <cost> <penalty> <solve ms> <latency ms> <stop ids in the order visited>
+// where the latency also accounts for the time spent waiting for a worker
+// and the stops are numbered from 1 in the order read
+
+struct Stop
+{
+    Vector2 position;
+
+    std::size_t id;
+
+    double service, open, close;
+};
+
+bool operator==(const Stop& A, const Stop& B)
+{
+    return A.id == B.id;
+}
+
+template <>
+struct Spatial<Stop>
+{
+    static constexpr bool value = true;
+
+    static const Vector2& position(const Stop& stop) { return stop.position; }
+};
+
+struct Instance
+{
+    std::string name;
+
+    bool windows;
+
+    double departure;
+
+    std::vector<Stop> stops;
+
+    // The durations amongst the stops laid out as by DistanceMatrix, if any
+    std::shared_ptr<const double> durations;
+
+    // How the euclidean durations are rounded, if evaluated
+    BinaryInstance::Rounding rounding = BinaryInstance::none;
+};
+
+template <typename T>
+T str2num(const std::string&);
+
+// Reads the next line that is neither blank nor a comment
+bool next(std::istream& is, std::string& line)
+{
+    while (std::getline(is, line))
+    {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+
+        if (first != std::string::npos && line[first] != '#')
+            return true;
+    }
+
+    return false;
+}
+
+bool read(std::istream& is, Instance& instance)
+{
+    std::string line;
+
+    if (!next(is, line))
+        return false;
+
+    std::istringstream header(line);
+
+    std::string type; std::size_t n = 0UL;
+
+    if (!(header >> instance.name >> type >> n) || (type != "TSP" && type != "TSPTW"))
+    {
+        std::cerr << "<ERR>: Malformed header (" << line << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    instance.windows = type == "TSPTW"; instance.departure = 0.0;
+
+    if (instance.windows && !(header >> instance.departure))
+    {
+        std::cerr << "<ERR>: Missing departure time (" << line << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
+    instance.stops.clear(); instance.stops.reserve(n + 1UL);
+
+    for (std::size_t id = 0UL; id <= n; id++)
+    {
+        if (!next(is, line))
+        {
+            std::cerr << "<ERR>: Instance " << instance.name << " ended prematurely" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::istringstream fields(line);
+
+        double x, y, service = 0.0, open = 0.0, close = std::numeric_limits<double>::infinity();
+
+        if (!(fields >> x >> y) || (instance.windows && !(fields >> service >> open >> close)))
+        {
+            std::cerr << "<ERR>: Malformed stop (" << line << ")" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+
+        instance.stops.push_back(Stop{ Vector2(x, y), id, service, open, close });
+    }
+
+    return true;
+}
+
+// Exits should the file be missing or malformed
+void load(const std::string& path, Instance& instance)
+{
+    try
+    {
+        const auto file = std::make_shared<const BinaryInstance>(path);
+
+        instance.name = path.substr(0UL, path.size() - 4UL); instance.departure = file->departure();
+
+        instance.stops.clear(); instance.stops.reserve(file->size());
+
+        instance.windows = false;
+
+        for (std::size_t id = 0UL; id < file->size(); id++)
+        {
+            const std::pair<double, double> window = file->window(id);
+
+            instance.stops.push_back(Stop{ file->position(id), id, file->service(id), window.first, window.second });
+
+            instance.windows = instance.windows || window.first > 0.0 || window.second < std::numeric_limits<double>::infinity();
+        }
+
+        instance.durations = file->durations(); instance.rounding = file->rounding();
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "<ERR>: " << exception.what() << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const std::string FILE(argc > 1 ? argv[1] : "-");
+
+    const double SECONDS = argc > 2 ? str2num<double>(argv[2]) : 0.05;
+
+    const std::size_t THREADS = argc > 3 ? str2num<std::size_t>(argv[3]) : std::max(1U, std::thread::hardware_concurrency());
+
+    const bool binary = FILE.size() > 4UL && FILE.compare(FILE.size() - 4UL, 4UL, ".bin") == 0;
+
+    std::ifstream file;
+
+    if (FILE != "-" && !binary)
+    {
+        file.open(FILE);
+
+        if (!file)
+        {
+            std::cerr << "<ERR>: Unable to open " << FILE << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    std::istream& is = FILE != "-" ? file : std::cin;
+
+    using Clock = std::chrono::steady_clock;
+
+    auto milliseconds = [](Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    // Results are written one line at a time
+    std::mutex output;
+
+    // No more than a few instances per worker are held in memory at a time
+    std::mutex mutex; std::condition_variable condition; std::size_t inflight = 0UL;
+
+    const std::size_t capacity = 4UL * THREADS;
+
+    auto solve = [&](const Instance& instance, std::size_t index, Clock::time_point received)
+    {
+        const Clock::time_point start = Clock::now();
+
+        const Stop& depot = instance.stops.front();
+
+        const std::vector<Stop> stops(instance.stops.begin() + 1, instance.stops.end());
+
+        auto service = [](const Stop& stop) { return stop.service; };
+
+        const BinaryInstance::Rounding rounding = instance.rounding;
+
+        auto euclidean = [rounding](const Stop& A, const Stop& B)
+        {
+            const double xdiff = A.position.x() - B.position.x();
+            const double ydiff = A.position.y() - B.position.y();
+
+            return BinaryInstance::round(std::sqrt(xdiff * xdiff + ydiff * ydiff), rounding);
+        };
+
+        // Every stage is granted whatever remains of the budget
+        const Deadline deadline(SECONDS);
+
+        LocalSearch::Options options;
+
+        auto remaining = [&deadline, &options, SECONDS]() -> const LocalSearch::Options&
+        {
+            options.seconds = std::max(0.0, SECONDS - deadline.elapsed());
+
+            return options;
+        };
+
+        std::vector<Stop> route; double cost, penalty = 0.0;
+
+        if (!instance.windows)
+        {
+            tsp<Stop> path = instance.durations
+                ? tsp<Stop>(depot, stops, service, euclidean, instance.durations, true)
+                : tsp<Stop>(depot, stops, service, euclidean, true);
+
+            path = path.greedy(1UL).opt2(remaining()).oropt(remaining());
+
+            options.kicks = std::numeric_limits<std::size_t>::max();
+
+            path = path.linkernighan(remaining());
+
+            route = path.elements(); cost = path.cost();
+        }
+        else
+        {
+            auto window = [](const Stop& stop) { return tsptw<Stop>::Timewindow(stop.open, stop.close); };
+
+            tsptw<Stop> path = instance.durations
+                ? tsptw<Stop>(depot, stops, service, euclidean, instance.departure, window, instance.durations, true)
+                : tsptw<Stop>(depot, stops, service, euclidean, instance.departure, window, true);
+
+            path = path.nneighbour();
+
+            Annealing::Parallel parallel;
+
+            parallel.seed = index;
+
+            // Leaving a tenth of the budget for the post-optimisation
+            Control control;
+
+            control.seconds = 0.9 * remaining().seconds;
+
+            path = path.cannealing(parallel, control).oropt(remaining()).or3opt(remaining());
+
+            route = path.elements(); cost = path.cost(); penalty = path.penalty();
+        }
+
+        const Clock::time_point finish = Clock::now();
+
+        std::ostringstream line;
+
+        line
+        << instance.name << ' ' << cost << ' ' << penalty << ' '
+        << milliseconds(start, finish) << ' ' << milliseconds(received, finish);
+
+        for (const auto& stop : route)
+            line << ' ' << stop.id;
+
+        std::lock_guard<std::mutex> lock(output);
+
+        std::cout << line.str() << std::endl;
+    };
+
+    {
+        WorkStealingPool pool(THREADS > 1UL ? THREADS : 0UL);
+
+        Instance instance;
+
+        // A binary instance is the only one of its stream
+        if (binary)
+            load(FILE, instance);
+
+        for (std::size_t index = 0UL; binary ? index == 0UL : read(is, instance); index++)
+        {
+            const Clock::time_point received = Clock::now();
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                condition.wait(lock, [&]() { return inflight < capacity; });
+
+                inflight++;
+            }
+
+            pool.submit([&, instance, index, received]()
+            {
+                try
+                {
+                    solve(instance, index, received);
+                }
+                catch (const std::exception& exception)
+                {
+                    std::lock_guard<std::mutex> lock(output);
+
+                    std::cerr << "<ERR>: Instance " << instance.name << ": " << exception.what() << std::endl;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    inflight--;
+                }
+
+                condition.notify_one();
+            });
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+template <typename T>
+T str2num(const std::string& str)
+{
+    std::stringstream ss(str);
+
+    T num;
+    if (ss >> num)
+    {
+        return num;
+    }
+    else
+    {
+        std::cerr << "<ERR>: Malformed arguement (" << str << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,476 @@
+
+#include "tsp.hpp"
+#include "vector2.hpp"
+#include "kdtree.hpp"
+#include "annealing.hpp"
+#include "instrument.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+#ifdef __GLIBC__
+#include <malloc.h>         // malloc_trim
+#endif
+
+// Benchmarks every stage over a corpus of instances with fixed seeds.
+//
+// Usage: BENCH [DIR] [THREADS]
+//
+// The TSPLIB instances of the table below are read from DIR/<name>.tsp,
+// their first node being the depot, and skipped unless present.
+// TSPTW instances are listed in DIR/tsptw.txt, one per line, as
+//     <file> <best known cost>
+// relative to DIR and in the format of Dumas et al., i.e. the number of
+// stops n (the depot included), the n x n travel times and n timewindows.
+// A synthetic TSP and TSPTW instance, generated with a fixed seed, are always solved.
+//
+// Every stage is written as a line of CSV:
+//     instance,type,size,stage,cost,penalty,best,gap,ms,iterations,rate,peak
+// where the gap to the best known cost is a percentage, only reported for
+// feasible routes, iterations is the number of annealing proposals, of
+// improving local search moves or of generations, rate is iterations per second
+// and peak is the growth of the resident memory of the process over the stage in KiB,
+// i.e. its high water mark during the stage less its resident memory as the stage began.
+// The high water mark is reset before every stage through /proc/self/clear_refs (Linux),
+// failing which the peak is left blank, and the memory freed by the earlier stages
+// is returned to the system beforehand (glibc), lest the stage reuse it unnoticed.
+// Both opt2 and sannealing, under either schedule, start from the route of nneighbour and opt2 respectively,
+// whereas cannealing starts from that of nneighbour, as would src/tsptw.cpp.
+// The memetic solver starts from the route of opt2 in the case of TSP instances
+// and otherwise takes the timewindows into account and starts from that of nneighbour
+
+struct Stop
+{
+    Vector2 position;
+
+    std::size_t id;
+};
+
+bool operator==(const Stop& A, const Stop& B)
+{
+    return A.id == B.id;
+}
+
+// A stop of an instance whose durations are given by a matrix rather than coordinates
+struct Node
+{
+    std::size_t id;
+};
+
+bool operator==(const Node& A, const Node& B)
+{
+    return A.id == B.id;
+}
+
+template <>
+struct Spatial<Stop>
+{
+    static constexpr bool value = true;
+
+    static const Vector2& position(const Stop& stop) { return stop.position; }
+};
+
+struct Instance
+{
+    std::string name, type;
+
+    bool spatial;
+
+    std::vector<Stop> stops;
+
+    // The travel times, should the stops carry no coordinates
+    std::vector<std::vector<double>> durations;
+
+    std::vector<std::pair<double, double>> windows;
+
+    double best;
+};
+
+template <typename T>
+T str2num(const std::string&);
+
+// A field of /proc/self/status in KiB, e.g. VmRSS, or 0 should it be unavailable
+std::size_t status(const std::string& field)
+{
+    std::ifstream file("/proc/self/status");
+
+    std::string line;
+
+    while (std::getline(file, line))
+        if (line.compare(0UL, field.size() + 1UL, field + ":") == 0)
+            return str2num<std::size_t>(line.substr(field.size() + 1UL));
+
+    return 0UL;
+}
+
+// Resets the high water mark of the resident memory to the current resident memory;
+// false should the kernel not support it
+bool reset()
+{
+    #ifdef __GLIBC__
+    malloc_trim(0UL);
+    #endif
+
+    std::ofstream refs("/proc/self/clear_refs");
+
+    return static_cast<bool>(refs << "5" << std::flush);
+}
+
+// TSPLIB rounds euclidean distances to the nearest integer (EUC_2D) or up (CEIL_2D)
+void euclidean(Instance& instance, bool ceil)
+{
+    const std::size_t n = instance.stops.size();
+
+    instance.durations.assign(n, std::vector<double>(n, 0.0));
+
+    for (std::size_t i = 0UL; i < n; i++)
+    {
+        for (std::size_t j = 0UL; j < n; j++)
+        {
+            const double xdiff = instance.stops[i].position.x() - instance.stops[j].position.x();
+            const double ydiff = instance.stops[i].position.y() - instance.stops[j].position.y();
+
+            const double distance = std::sqrt(xdiff * xdiff + ydiff * ydiff);
+
+            instance.durations[i][j] = ceil ? std::ceil(distance) : std::floor(distance + 0.5);
+        }
+    }
+
+    instance.windows.assign(n, std::make_pair(0.0, std::numeric_limits<double>::infinity()));
+
+    instance.type = "TSP"; instance.spatial = true;
+}
+
+bool tsplib(const std::string& path, Instance& instance)
+{
+    std::ifstream file(path);
+
+    if (!file)
+        return false;
+
+    std::string line; bool ceil = false;
+
+    while (std::getline(file, line) && line.find("NODE_COORD_SECTION") == std::string::npos)
+    {
+        if (line.find("EDGE_WEIGHT_TYPE") == std::string::npos)
+            continue;
+
+        if (line.find("CEIL_2D") != std::string::npos)
+            ceil = true;
+        else if (line.find("EUC_2D") == std::string::npos)
+        {
+            std::cerr << "<ERR>: Only EUC_2D and CEIL_2D coordinates are supported (" << path << ")" << std::endl;
+            return false;
+        }
+    }
+
+    while (std::getline(file, line) && line.find("EOF") == std::string::npos)
+    {
+        std::istringstream fields(line);
+
+        std::size_t id; double x, y;
+
+        if (fields >> id >> x >> y)
+            instance.stops.push_back(Stop{ Vector2(x, y), instance.stops.size() });
+    }
+
+    euclidean(instance, ceil);
+
+    return instance.stops.size() > 1UL;
+}
+
+bool dumas(const std::string& path, Instance& instance)
+{
+    std::ifstream file(path);
+
+    std::size_t n = 0UL;
+
+    if (!file || !(file >> n) || n < 2UL)
+        return false;
+
+    instance.durations.assign(n, std::vector<double>(n, 0.0));
+
+    for (std::size_t i = 0UL; i < n; i++)
+        for (std::size_t j = 0UL; j < n; j++)
+            if (!(file >> instance.durations[i][j]))
+                return false;
+
+    for (std::size_t i = 0UL; i < n; i++)
+    {
+        double open, close;
+
+        if (!(file >> open >> close))
+            return false;
+
+        instance.stops.push_back(Stop{ Vector2(), i });
+        instance.windows.emplace_back(open, close);
+    }
+
+    instance.type = "TSPTW"; instance.spatial = false;
+
+    return true;
+}
+
+// Uniformly distributed stops, whose rounded euclidean distances are the durations.
+// Should there be timewindows, they are centred at the arrival times of a random route
+Instance synthetic(const std::string& name, std::size_t size, bool windows, std::uint64_t seed)
+{
+    std::mt19937_64 engine(seed);
+    std::uniform_real_distribution<double> coordinate(0.0, windows ? 100.0 : 1000.0);
+
+    Instance instance;
+
+    instance.name = name; instance.best = std::numeric_limits<double>::quiet_NaN();
+
+    for (std::size_t i = 0UL; i <= size; i++)
+        instance.stops.push_back(Stop{ Vector2(coordinate(engine), coordinate(engine)), i });
+
+    euclidean(instance, false);
+
+    if (windows)
+    {
+        std::vector<std::size_t> route(size);
+
+        for (std::size_t i = 0UL; i < size; i++)
+            route[i] = i + 1UL;
+
+        std::shuffle(route.begin(), route.end(), engine);
+
+        double time = 0.0; std::size_t previous = 0UL;
+
+        for (const std::size_t id : route)
+        {
+            time += instance.durations[previous][id];
+
+            instance.windows[id] = std::make_pair(std::max(0.0, time - 50.0), time + 50.0);
+
+            previous = id;
+        }
+
+        instance.type = "TSPTW";
+    }
+
+    return instance;
+}
+
+template <typename T>
+void solve(const Instance& instance, const std::vector<T>& stops, std::size_t threads)
+{
+    const std::vector<std::vector<double>>& durations = instance.durations;
+    const std::vector<std::pair<double, double>>& windows = instance.windows;
+
+    const tsptw<T> path
+    (
+        stops.front(),
+        std::vector<T>(stops.begin() + 1, stops.end()),
+        [](const T&) { return 0.0; },
+        [&durations](const T& A, const T& B) { return durations[A.id][B.id]; },
+        0.0,
+        [&windows](const T& stop) { return windows[stop.id]; },
+        Spatial<T>::value
+    );
+
+    using Clock = std::chrono::steady_clock;
+
+    Annealing::Parallel parallel;
+
+    parallel.threads = parallel.chains = threads;
+    parallel.seed    = 1UL;
+
+    std::srand(1U);
+
+    std::size_t iterations = 0UL;
+
+    LocalSearch::Options options;
+
+    options.interval = std::numeric_limits<double>::infinity();
+    options.progress = [&iterations](const Progress& progress) { iterations = progress.iterations; };
+
+    const Control& control = options;
+
+    // The start of the current stage and the resident memory as it began, if tracked
+    Clock::time_point start; std::size_t resident = 0UL; bool tracked = false;
+
+    auto begin = [&]()
+    {
+        tracked = reset(); resident = status("VmRSS"); start = Clock::now();
+    };
+
+    auto report = [&](const std::string& stage, const tsp<T>& route)
+    {
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        const std::size_t peak = status("VmHWM");
+
+        tsptw<T> windowed(path); windowed = route;
+
+        const double cost = windowed.cost(), penalty = windowed.penalty();
+
+        std::cout
+        << instance.name << ',' << instance.type << ',' << stops.size() - 1UL << ',' << stage << ','
+        << std::fixed << std::setprecision(2) << cost << ',' << penalty << ',';
+
+        if (!std::isnan(instance.best))
+            std::cout << instance.best;
+
+        std::cout << ',';
+
+        if (!std::isnan(instance.best) && penalty <= 0.0)
+            std::cout << 100.0 * (cost - instance.best) / instance.best;
+
+        std::cout
+        << ',' << ms << ',' << iterations << ','
+        << (ms > 0.0 ? 1000.0 * static_cast<double>(iterations) / ms : 0.0) << ',';
+
+        if (tracked)
+            std::cout << (peak > resident ? peak - resident : 0UL);
+
+        std::cout << std::endl;
+
+        iterations = 0UL;
+    };
+
+    begin();
+
+    const tsp<T> nn = path.nneighbour();
+
+    report("nneighbour", nn);
+
+    begin();
+
+    const tsp<T> o2 = nn.opt2(options);
+
+    report("opt2", o2);
+
+    begin();
+
+    report("sannealing", o2.sannealing(parallel, control));
+
+    Annealing::Schedule adaptive; adaptive.kind = Annealing::Schedule::Adaptive;
+
+    begin();
+
+    report("sannealing-adaptive", o2.sannealing(adaptive, parallel, control));
+
+    tsptw<T> ca(path); ca = nn;
+
+    begin();
+
+    report("cannealing", ca.cannealing(parallel, control));
+
+    Memetic::Options memetic;
+
+    memetic.threads = threads;
+    memetic.seed    = 1UL;
+
+    begin();
+
+    if (instance.type == "TSP")
+        report("memetic", o2.memetic(memetic, control));
+    else
+        report("memetic", ca.memetic(memetic, control));
+}
+
+void solve(const Instance& instance, std::size_t threads)
+{
+    if (instance.spatial)
+    {
+        solve(instance, instance.stops, threads);
+
+        return;
+    }
+
+    // Only the ids matter
+    std::vector<Node> nodes;
+
+    for (const auto& stop : instance.stops)
+        nodes.push_back(Node{ stop.id });
+
+    solve(instance, nodes, threads);
+}
+
+int main(int argc, char * argv[])
+{
+    const std::string DIR(argc > 1 ? argv[1] : "instances");
+
+    const std::size_t THREADS = argc > 2 ? str2num<std::size_t>(argv[2]) : 1UL;
+
+    // Best known tour lengths
+    const std::vector<std::pair<std::string, double>> corpus
+    {
+        { "berlin52", 7542.0 }, { "eil51", 426.0 }, { "kroA100", 21282.0 },
+        { "ch150", 6528.0 }, { "a280", 2579.0 }, { "pr1002", 259045.0 }
+    };
+
+    std::cout << "instance,type,size,stage,cost,penalty,best,gap,ms,iterations,rate,peak" << std::endl;
+
+    for (const auto& entry : corpus)
+    {
+        Instance instance; instance.name = entry.first; instance.best = entry.second;
+
+        if (!tsplib(DIR + "/" + entry.first + ".tsp", instance))
+        {
+            std::cerr << "<MSG>: Skipping " << entry.first << " (" << DIR << "/" << entry.first << ".tsp)" << std::endl;
+            continue;
+        }
+
+        solve(instance, THREADS);
+    }
+
+    std::ifstream manifest(DIR + "/tsptw.txt");
+
+    std::string file; double best;
+
+    while (manifest >> file >> best)
+    {
+        Instance instance; instance.name = file; instance.best = best;
+
+        if (!dumas(DIR + "/" + file, instance))
+        {
+            std::cerr << "<MSG>: Skipping " << file << " (" << DIR << "/" << file << ")" << std::endl;
+            continue;
+        }
+
+        solve(instance, THREADS);
+    }
+
+    solve(synthetic("synthetic1000", 1000UL, false, 1UL), THREADS);
+
+    solve(synthetic("synthetic100tw", 100UL, true, 2UL), THREADS);
+
+    #ifdef __INSTRUMENT__
+    std::ofstream trace("trace.csv");
+
+    Instrument::dump(trace);
+    #endif
+
+    return 0;
+}
+
+template <typename T>
+T str2num(const std::string& str)
+{
+    std::stringstream ss(str);
+
+    T num;
+    if (ss >> num)
+    {
+        return num;
+    }
+    else
+    {
+        std::cerr << "<ERR>: Malformed arguement (" << str << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,204 @@
+#include "binary.hpp"
+#include "threadpool.hpp"
+#include <string>       // std::string
+#include <vector>       // std::vector
+#include <fstream>      // std::ofstream
+#include <stdexcept>    // std::runtime_error
+#include <algorithm>    // std::min, std::copy
+#include <cstring>      // std::memcmp, std::memcpy, std::memset
+#include <cmath>        // std::ceil, std::floor
+
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // fstat
+#include <fcntl.h>      // open
+#include <unistd.h>     // close
+
+namespace
+{
+    const char magic[8] = { 'T', 'S', 'P', 'B', 'I', 'N', '\0', '\0' };
+
+    // The bytes spanned by an array of n doubles padded to a 64-byte boundary
+    std::size_t section(std::size_t n)
+    {
+        return DistanceMatrix::stride(n) * sizeof(double);
+    }
+}
+
+static_assert(sizeof(BinaryInstance::Header) == 64UL, "The header spans a cache line");
+
+constexpr std::uint32_t BinaryInstance::version;
+
+// Constructors & Destructor:
+BinaryInstance::BinaryInstance(const std::string& path)
+:
+_address(nullptr), _length(0UL), _header(nullptr),
+_x(nullptr), _y(nullptr), _service(nullptr), _open(nullptr), _close(nullptr), _durations(nullptr)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        throw std::runtime_error("unable to open " + path);
+
+    struct stat status;
+
+    if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+
+        throw std::runtime_error("truncated instance " + path);
+    }
+
+    _length  = static_cast<std::size_t>(status.st_size);
+    _address = ::mmap(nullptr, _length, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping outlives the descriptor
+    ::close(fd);
+
+    if (_address == MAP_FAILED)
+        throw std::runtime_error("unable to map " + path);
+
+    const char * bytes = static_cast<const char *>(_address);
+
+    _header = reinterpret_cast<const Header *>(bytes);
+
+    // The size is bounded by the file before any section is sized after it,
+    // lest a corrupt header overflow their lengths
+    const std::size_t available = _length - sizeof(Header), n = _header->size;
+
+    const std::size_t length = n <= available / (5UL * sizeof(double)) ? section(n) : 0UL;
+
+    if
+    (
+        std::memcmp(_header->magic, magic, sizeof(magic)) != 0 ||
+        _header->version != version ||
+        _header->rounding > up ||
+        n > available / (5UL * sizeof(double)) ||
+        _header->stride != DistanceMatrix::stride(n) ||
+        available < 5UL * length ||
+        (_header->matrix && n > 0UL && DistanceMatrix::stride(n) > (available - 5UL * length) / (n * sizeof(double)))
+    )
+    {
+        ::munmap(_address, _length);
+
+        throw std::runtime_error("malformed instance " + path);
+    }
+
+    bytes += sizeof(Header);
+
+    _x       = reinterpret_cast<const double *>(bytes);
+    _y       = reinterpret_cast<const double *>(bytes + length);
+    _service = reinterpret_cast<const double *>(bytes + 2UL * length);
+    _open    = reinterpret_cast<const double *>(bytes + 3UL * length);
+    _close   = reinterpret_cast<const double *>(bytes + 4UL * length);
+
+    if (_header->matrix)
+        _durations = reinterpret_cast<const double *>(bytes + 5UL * length);
+}
+
+BinaryInstance::~BinaryInstance()
+{
+    ::munmap(_address, _length);
+}
+
+std::shared_ptr<const double> BinaryInstance::durations() const
+{
+    if (!_durations)
+        return nullptr;
+
+    return std::shared_ptr<const double>(shared_from_this(), _durations);
+}
+
+double BinaryInstance::round(double distance, Rounding rounding)
+{
+    switch (rounding)
+    {
+        case nearest: return std::floor(distance + 0.5);
+
+        case up: return std::ceil(distance);
+
+        default: return distance;
+    }
+}
+
+void BinaryInstance::write
+(
+    const std::string& path,
+    const std::vector<Vector2>& positions,
+    const std::vector<double>& service,
+    const std::vector<std::pair<double, double>>& windows,
+    double departure,
+    Rounding rounding,
+    const DistanceMatrix::Function& duration,
+    std::size_t threads
+)
+{
+    const std::size_t n = positions.size(), stride = DistanceMatrix::stride(n);
+
+    if (service.size() != n || windows.size() != n)
+        throw std::runtime_error("mismatched number of service times or timewindows");
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    if (!file)
+        throw std::runtime_error("unable to create " + path);
+
+    Header header;
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+
+    header.version   = version;
+    header.matrix    = duration ? 1U : 0U;
+    header.size      = n;
+    header.stride    = stride;
+    header.departure = departure;
+    header.rounding  = rounding;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<double> values(stride, 0.0);
+
+    auto emit = [&file, &values, stride](const std::vector<double>& array)
+    {
+        std::copy(array.begin(), array.end(), values.begin());
+
+        file.write(reinterpret_cast<const char *>(values.data()), stride * sizeof(double));
+    };
+
+    std::vector<double> x, y, open, close;
+
+    for (std::size_t i = 0UL; i < n; i++)
+    {
+        x.push_back(positions[i].x()); y.push_back(positions[i].y());
+
+        open.push_back(windows[i].first); close.push_back(windows[i].second);
+    }
+
+    emit(x); emit(y); emit(service); emit(open); emit(close);
+
+    if (duration)
+    {
+        ThreadPool pool(threads > 1UL ? threads : 0UL);
+
+        // A block of rows is evaluated concurrently before being written at once
+        const std::size_t rows = 64UL;
+
+        std::vector<double> block(rows * stride, 0.0);
+
+        for (std::size_t first = 0UL; first < n; first += rows)
+        {
+            const std::size_t count = std::min(rows, n - first);
+
+            pool.parallel(count, [&block, &duration, first, n, stride](std::size_t r)
+            {
+                for (std::size_t j = 0UL; j < n; j++)
+                    block[r * stride + j] = duration(first + r, j);
+            });
+
+            file.write(reinterpret_cast<const char *>(block.data()), count * stride * sizeof(double));
+        }
+    }
+
+    if (!file.flush())
+        throw std::runtime_error("unable to write " + path);
+}
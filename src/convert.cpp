@@ -0,0 +1,210 @@
+
+#include "binary.hpp"
+#include "vector2.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+// Converts an instance into the memory mapped binary format of BinaryInstance.
+//
+// Usage: CONVERT IN OUT [MATRIX] [THREADS]
+//
+// The input is either a TSPLIB file of NODE_COORD_SECTION, whose first node
+// is the depot, or a single instance in the format read by BATCH.
+// Unless MATRIX is 0, the euclidean durations are stored as well,
+// evaluated by the specified number of threads and, as by TSPLIB,
+// rounded to the nearest integer (EUC_2D) or up (CEIL_2D).
+// The rounding is recorded either way, for BATCH to evaluate them alike
+
+template <typename T>
+T str2num(const std::string&);
+
+struct Instance
+{
+    std::vector<Vector2> positions;
+
+    std::vector<double> service;
+
+    std::vector<std::pair<double, double>> windows;
+
+    double departure = 0.0;
+
+    // How the euclidean distances are rounded, as by TSPLIB
+    BinaryInstance::Rounding rounding = BinaryInstance::none;
+
+    void push(const Vector2& position, double s, double open, double close)
+    {
+        positions.push_back(position); service.push_back(s); windows.emplace_back(open, close);
+    }
+};
+
+void fail(const std::string& message)
+{
+    std::cerr << "<ERR>: " << message << std::endl;
+    std::exit(EXIT_FAILURE);
+}
+
+// Reads the next line that is neither blank nor a comment
+bool next(std::istream& is, std::string& line)
+{
+    while (std::getline(is, line))
+    {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+
+        if (first != std::string::npos && line[first] != '#')
+            return true;
+    }
+
+    return false;
+}
+
+void tsplib(std::istream& is, Instance& instance)
+{
+    std::string line;
+
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    instance.rounding = BinaryInstance::nearest;
+
+    while (std::getline(is, line) && line.find("NODE_COORD_SECTION") == std::string::npos)
+    {
+        if (line.find("EDGE_WEIGHT_TYPE") == std::string::npos)
+            continue;
+
+        if (line.find("CEIL_2D") != std::string::npos)
+            instance.rounding = BinaryInstance::up;
+        else if (line.find("EUC_2D") == std::string::npos)
+            fail("Only EUC_2D and CEIL_2D coordinates are supported (" + line + ")");
+    }
+
+    while (std::getline(is, line) && line.find("EOF") == std::string::npos)
+    {
+        std::istringstream fields(line);
+
+        std::size_t id; double x, y;
+
+        if (fields >> id >> x >> y)
+            instance.push(Vector2(x, y), 0.0, 0.0, infinity);
+    }
+}
+
+void batch(std::istream& is, Instance& instance)
+{
+    std::string line, name, type; std::size_t n = 0UL;
+
+    if (!next(is, line) || !(std::istringstream(line) >> name >> type >> n) || (type != "TSP" && type != "TSPTW"))
+        fail("Malformed header (" + line + ")");
+
+    const bool windows = type == "TSPTW";
+
+    if (windows && !(std::istringstream(line) >> name >> type >> n >> instance.departure))
+        fail("Missing departure time (" + line + ")");
+
+    for (std::size_t id = 0UL; id <= n; id++)
+    {
+        if (!next(is, line))
+            fail("Instance " + name + " ended prematurely");
+
+        std::istringstream fields(line);
+
+        double x, y, service = 0.0, open = 0.0, close = std::numeric_limits<double>::infinity();
+
+        if (!(fields >> x >> y) || (windows && !(fields >> service >> open >> close)))
+            fail("Malformed stop (" + line + ")");
+
+        instance.push(Vector2(x, y), service, open, close);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 3)
+        fail("Usage: CONVERT IN OUT [MATRIX] [THREADS]");
+
+    const std::string IN(argv[1]), OUT(argv[2]);
+
+    const bool MATRIX = argc > 3 ? str2num<int>(argv[3]) != 0 : true;
+
+    const std::size_t THREADS = argc > 4 ? str2num<std::size_t>(argv[4]) : std::max(1U, std::thread::hardware_concurrency());
+
+    std::ifstream file(IN);
+
+    if (!file)
+        fail("Unable to open " + IN);
+
+    std::string first;
+
+    if (!next(file, first))
+        fail("Empty instance " + IN);
+
+    file.clear(); file.seekg(0);
+
+    Instance instance;
+
+    // A TSPLIB file opens with its specification, e.g. NAME: berlin52
+    if (first.find(':') != std::string::npos)
+        tsplib(file, instance);
+    else
+        batch(file, instance);
+
+    if (instance.positions.size() < 2UL)
+        fail("Too few stops in " + IN);
+
+    const std::vector<Vector2>& positions = instance.positions;
+
+    const BinaryInstance::Rounding rounding = instance.rounding;
+
+    DistanceMatrix::Function euclidean;
+
+    if (MATRIX)
+        euclidean = [&positions, rounding](std::size_t i, std::size_t j)
+        {
+            const double xdiff = positions[i].x() - positions[j].x();
+            const double ydiff = positions[i].y() - positions[j].y();
+
+            return BinaryInstance::round(std::sqrt(xdiff * xdiff + ydiff * ydiff), rounding);
+        };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        BinaryInstance::write(OUT, positions, instance.service, instance.windows, instance.departure, rounding, euclidean, THREADS);
+    }
+    catch (const std::exception& e)
+    {
+        fail(e.what());
+    }
+
+    std::cout
+    << OUT << ": " << positions.size() << " stops" << (MATRIX ? " and their durations" : "") << " in "
+    << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+    return 0;
+}
+
+template <typename T>
+T str2num(const std::string& str)
+{
+    std::stringstream ss(str);
+
+    T num;
+    if (ss >> num)
+    {
+        return num;
+    }
+    else
+    {
+        std::cerr << "<ERR>: Malformed arguement (" << str << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,169 @@
+#include "decomposition.hpp"
+#include "hilbert.hpp"
+#include "kdtree.hpp"
+#include "threadpool.hpp"
+#include "vector2.hpp"
+#include <vector>       // std::vector
+#include <utility>      // std::pair, std::move
+#include <cstdint>      // std::uint64_t
+#include <cmath>        // std::ceil, std::sqrt
+#include <algorithm>    // std::min, std::max, std::sort
+#include <functional>   // std::less
+
+namespace
+{
+    // The centroid of every non empty cluster, as labelled
+    std::vector<Vector2> centroids(const std::vector<Vector2>& points, const std::vector<std::size_t>& labels, std::size_t k)
+    {
+        std::vector<double> x(k, 0.0), y(k, 0.0); std::vector<std::size_t> count(k, 0UL);
+
+        for (std::size_t i = 0UL; i < points.size(); i++)
+        {
+            x[labels[i]] += points[i].x(); y[labels[i]] += points[i].y(); count[labels[i]]++;
+        }
+
+        std::vector<Vector2> centroids;
+
+        for (std::size_t c = 0UL; c < k; c++)
+            if (count[c] > 0UL)
+                centroids.emplace_back(x[c] / count[c], y[c] / count[c]);
+
+        return centroids;
+    }
+
+    // Labels every point by the cell of a square grid enclosing it
+    std::vector<std::size_t> grid(const std::vector<Vector2>& points, std::size_t k, std::size_t& cells)
+    {
+        double minX = points.front().x(), maxX = minX, minY = points.front().y(), maxY = minY;
+
+        for (const auto& point : points)
+        {
+            minX = std::min(minX, point.x()); maxX = std::max(maxX, point.x());
+            minY = std::min(minY, point.y()); maxY = std::max(maxY, point.y());
+        }
+
+        const std::size_t side = std::max<std::size_t>(1UL, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(k)))));
+
+        const double width  = std::max(maxX - minX, 1e-9) / side;
+        const double height = std::max(maxY - minY, 1e-9) / side;
+
+        std::vector<std::size_t> labels(points.size());
+
+        for (std::size_t i = 0UL; i < points.size(); i++)
+        {
+            const std::size_t column = std::min(side - 1UL, static_cast<std::size_t>((points[i].x() - minX) / width));
+            const std::size_t row    = std::min(side - 1UL, static_cast<std::size_t>((points[i].y() - minY) / height));
+
+            labels[i] = row * side + column;
+        }
+
+        cells = side * side;
+
+        return labels;
+    }
+
+    // Labels every point by its nearest centroid, once Lloyd's iterations are over
+    std::vector<std::size_t> kmeans
+    (
+        const std::vector<Vector2>& points,
+        const std::vector<std::size_t>& order,
+        std::size_t k,
+        std::size_t iterations,
+        ThreadPool& pool,
+        std::size_t& clusters
+    )
+    {
+        // Seeding with points evenly spaced along the curve spreads the centroids
+        // in proportion to the density of the points
+        std::vector<Vector2> means; means.reserve(k);
+
+        for (std::size_t c = 0UL; c < k; c++)
+            means.push_back(points[order[(points.size() * (2UL * c + 1UL)) / (2UL * k)]]);
+
+        std::vector<std::size_t> labels(points.size(), 0UL);
+
+        const std::size_t chunks = std::max<std::size_t>(1UL, 4UL * pool.size());
+
+        for (std::size_t iteration = 0UL; ; iteration++)
+        {
+            const KDTree tree(means);
+
+            pool.parallel(chunks, [&](std::size_t c)
+            {
+                for (std::size_t i = points.size() * c / chunks; i < points.size() * (c + 1UL) / chunks; i++)
+                    labels[i] = tree.nearest(points[i]);
+            });
+
+            if (iteration == iterations)
+                break;
+
+            means = centroids(points, labels, means.size());
+        }
+
+        clusters = means.size();
+
+        return labels;
+    }
+}
+
+std::vector<std::vector<std::size_t>> Decomposition::partition(const std::vector<Vector2>& points, const Options& options)
+{
+    if (points.empty())
+        return std::vector<std::vector<std::size_t>>();
+
+    ThreadPool pool(options.threads > 1UL ? options.threads : 0UL);
+
+    const HilbertCurve curve(points);
+
+    // The points in the order of the curve
+    std::vector<std::pair<std::uint64_t, std::size_t>> keys(points.size());
+
+    for (std::size_t i = 0UL; i < points.size(); i++)
+        keys[i] = std::make_pair(curve(points[i]), i);
+
+    pool.sort(keys.begin(), keys.end(), std::less<std::pair<std::uint64_t, std::size_t>>());
+
+    std::vector<std::size_t> order(points.size());
+    for (std::size_t i = 0UL; i < points.size(); i++)
+        order[i] = keys[i].second;
+
+    const std::size_t k = std::max<std::size_t>
+    (
+        1UL, (points.size() + std::max<std::size_t>(1UL, options.cluster) - 1UL) / std::max<std::size_t>(1UL, options.cluster)
+    );
+
+    std::size_t labelled = 0UL;
+
+    const std::vector<std::size_t> labels = options.partition == Partition::Grid
+                                          ? grid(points, k, labelled)
+                                          : kmeans(points, order, k, options.iterations, pool, labelled);
+
+    // The members of every cluster, in the order of the curve
+    std::vector<std::vector<std::size_t>> members(labelled);
+
+    for (const auto i : order)
+        members[labels[i]].push_back(i);
+
+    std::vector<std::vector<std::size_t>> clusters;
+
+    for (auto& cluster : members)
+        if (!cluster.empty())
+            clusters.push_back(std::move(cluster));
+
+    const std::vector<Vector2> means(centroids(points, labels, labelled));
+
+    // The clusters in the order of their centroids along the curve
+    std::vector<std::pair<std::uint64_t, std::size_t>> ranks(clusters.size());
+
+    for (std::size_t c = 0UL; c < clusters.size(); c++)
+        ranks[c] = std::make_pair(curve(means[c]), c);
+
+    std::sort(ranks.begin(), ranks.end());
+
+    std::vector<std::vector<std::size_t>> ordered; ordered.reserve(clusters.size());
+
+    for (const auto& rank : ranks)
+        ordered.push_back(std::move(clusters[rank.second]));
+
+    return ordered;
+}
@@ -0,0 +1,70 @@
+#include "hilbert.hpp"
+#include "vector2.hpp"
+#include <vector>       // std::vector
+#include <cstdint>      // std::uint64_t, std::uint32_t
+#include <algorithm>    // std::min, std::max, std::swap
+
+// Constructors:
+constexpr unsigned HilbertCurve::order;
+
+HilbertCurve::HilbertCurve(const std::vector<Vector2>& points)
+:
+_x(0.0), _y(0.0), _scale(0.0)
+{
+    if (points.empty())
+        return;
+
+    double maxX = points.front().x(), maxY = points.front().y();
+
+    _x = maxX; _y = maxY;
+
+    for (const auto& point : points)
+    {
+        _x = std::min(_x, point.x()); maxX = std::max(maxX, point.x());
+        _y = std::min(_y, point.y()); maxY = std::max(maxY, point.y());
+    }
+
+    // Both axes are scaled alike, so as for the curve not to be stretched
+    const double span = std::max(maxX - _x, maxY - _y);
+
+    if (span > 0.0)
+        _scale = static_cast<double>((1UL << order) - 1UL) / span;
+}
+
+// Mapping:
+std::uint64_t HilbertCurve::operator()(const Vector2& point) const
+{
+    const std::uint32_t last = (1U << order) - 1U;
+
+    auto cell = [last](double offset)
+    {
+        return offset <= 0.0 ? 0U : std::min(last, static_cast<std::uint32_t>(offset));
+    };
+
+    std::uint32_t x = cell((point.x() - _x) * _scale);
+    std::uint32_t y = cell((point.y() - _y) * _scale);
+
+    std::uint64_t d = 0UL;
+
+    for (std::uint32_t s = 1U << (order - 1U); s > 0U; s >>= 1U)
+    {
+        const std::uint32_t rx = (x & s) ? 1U : 0U;
+        const std::uint32_t ry = (y & s) ? 1U : 0U;
+
+        d += static_cast<std::uint64_t>(s) * static_cast<std::uint64_t>(s) * ((3U * rx) ^ ry);
+
+        // Rotating the quadrant so that the curve within it is in the canonical orientation
+        if (ry == 0U)
+        {
+            if (rx == 1U)
+            {
+                x = last - x;
+                y = last - y;
+            }
+
+            std::swap(x, y);
+        }
+    }
+
+    return d;
+}
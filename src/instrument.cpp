@@ -0,0 +1,96 @@
+
+#include "instrument.hpp"
+
+#ifdef __INSTRUMENT__
+
+#include <mutex>        // std::mutex, std::lock_guard
+#include <new>          // std::bad_alloc
+#include <cstdlib>      // std::malloc, std::free
+
+namespace
+{
+    thread_local std::size_t counter = 0UL;
+
+    std::mutex mutex;
+
+    std::vector<Instrument::Record>& records()
+    {
+        static std::vector<Instrument::Record> records;
+
+        return records;
+    }
+}
+
+// Every allocation of the process is counted by the thread performing it
+void * operator new(std::size_t size)
+{
+    counter++;
+
+    if (void * pointer = std::malloc(size > 0UL ? size : 1UL))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void * pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+std::size_t Instrument::allocations()
+{
+    return counter;
+}
+
+void Instrument::record(const Record& record)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    records().push_back(record);
+}
+
+std::vector<Instrument::Record> Instrument::trace()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return records();
+}
+
+void Instrument::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    records().clear();
+}
+
+void Instrument::dump(std::ostream& os)
+{
+    os
+    << "solver,chain,step,temperature,pressure,cost,penalty,iterations,accepted,acceptance,improved,"
+    << "generate_ms,evaluate_ms,apply_ms,elapsed_ms,allocations,allocations_per_iteration\n";
+
+    for (const Record& record : trace())
+    {
+        const Sample& sample = record.sample;
+
+        const double iterations = static_cast<double>(sample.iterations);
+
+        os
+        << record.solver << ',' << record.chain << ',' << record.step << ','
+        << record.temperature << ',' << record.pressure << ',' << record.cost << ',' << record.penalty << ','
+        << sample.iterations << ',' << sample.accepted << ','
+        << (sample.iterations > 0UL ? sample.accepted / iterations : 0.0) << ',' << sample.improved << ','
+        << 1000.0 * sample.generate << ',' << 1000.0 * sample.evaluate << ',' << 1000.0 * sample.apply << ','
+        << 1000.0 * sample.elapsed << ',' << sample.allocations << ','
+        << (sample.iterations > 0UL ? sample.allocations / iterations : 0.0) << '\n';
+    }
+
+    os.flush();
+}
+
+#endif
@@ -0,0 +1,305 @@
+
+#include "kdtree.hpp"
+#include "vector2.hpp"
+#include "simd.hpp"
+#include <vector>       // std::vector
+#include <queue>        // std::priority_queue
+#include <utility>      // std::pair
+#include <algorithm>    // std::nth_element, std::minmax_element
+#include <numeric>      // std::iota
+
+// Constructors:
+constexpr std::size_t KDTree::bucket;
+constexpr std::size_t KDTree::none;
+
+KDTree::KDTree()
+:
+_points(), _ids(), _position(), _tree(0UL), _tail(0UL), _vertical(), _alive(), _removed(), _masked()
+{
+}
+
+KDTree::KDTree(const std::vector<Vector2>& points)
+:
+_points(),
+_ids(points.size()), _position(points.size()),
+_tree(points.size()), _tail(0UL),
+_vertical(points.size()), _alive(points.size()),
+_removed(points.size(), false),
+_masked(points.size(), 0U)
+{
+    std::iota(_ids.begin(), _ids.end(), 0UL);
+
+    _build(0UL, _ids.size(), points);
+
+    std::vector<Vector2> ordered; ordered.reserve(_ids.size());
+
+    for (std::size_t p = 0UL; p < _ids.size(); p++)
+    {
+        ordered.push_back(points[_ids[p]]);
+
+        _position[_ids[p]] = p;
+    }
+
+    _points = Points(ordered);
+}
+
+KDTree::KDTree(const KDTree& base, const std::vector<std::size_t>& kept, const std::vector<Vector2>& additions)
+:
+KDTree()
+{
+    const std::size_t positions = base._ids.size() + additions.size(), size = kept.size() + additions.size();
+
+    if (positions - base._tree > 4UL * bucket || 2UL * size < positions)
+    {
+        std::vector<Vector2> points; points.reserve(size);
+
+        for (const auto id : kept)
+            points.push_back(base.point(id));
+
+        points.insert(points.end(), additions.begin(), additions.end());
+
+        *this = KDTree(points);
+
+        for (std::size_t id = 0UL; id < kept.size(); id++)
+            if (base._removed[kept[id]])
+                remove(id);
+
+        return;
+    }
+
+    *this = base;
+
+    _ids.assign(positions, none);
+    _position.resize(size);
+    _removed.resize(size);
+
+    std::vector<bool> left(base.size(), true);
+
+    for (std::size_t id = 0UL; id < kept.size(); id++)
+    {
+        _position[id] = base._position[kept[id]];
+        _removed[id]  = base._removed[kept[id]];
+
+        _ids[_position[id]] = id;
+
+        left[kept[id]] = false;
+    }
+
+    for (std::size_t id = 0UL; id < base.size(); id++)
+        if (left[id] && !base._removed[id])
+            _erase(base._position[id]);
+
+    std::vector<Vector2> ordered; ordered.reserve(positions);
+
+    for (std::size_t p = 0UL; p < base._ids.size(); p++)
+        ordered.emplace_back(base._points.x(p), base._points.y(p));
+
+    for (std::size_t a = 0UL; a < additions.size(); a++)
+    {
+        _position[kept.size() + a] = ordered.size();
+        _removed[kept.size() + a]  = false;
+
+        _ids[ordered.size()] = kept.size() + a;
+
+        ordered.push_back(additions[a]);
+    }
+
+    _points = Points(ordered);
+
+    _masked.resize(positions, 0U);
+
+    _tail += additions.size();
+}
+
+void KDTree::_build(std::size_t lo, std::size_t hi, const std::vector<Vector2>& points)
+{
+    if (lo >= hi)
+        return;
+
+    if (hi - lo <= bucket)
+    {
+        _alive[lo] = hi - lo;
+
+        return;
+    }
+
+    const std::size_t mid = (lo + hi) / 2UL;
+
+    auto x = [&points](std::size_t id) { return points[id].x(); };
+    auto y = [&points](std::size_t id) { return points[id].y(); };
+
+    double xmin = x(_ids[lo]), xmax = xmin, ymin = y(_ids[lo]), ymax = ymin;
+    for (std::size_t p = lo + 1UL; p < hi; p++)
+    {
+        xmin = std::min(xmin, x(_ids[p])); xmax = std::max(xmax, x(_ids[p]));
+        ymin = std::min(ymin, y(_ids[p])); ymax = std::max(ymax, y(_ids[p]));
+    }
+
+    const bool vertical = (xmax - xmin) >= (ymax - ymin);
+
+    std::nth_element
+    (
+        _ids.begin() + lo,
+        _ids.begin() + mid,
+        _ids.begin() + hi,
+        [&points, vertical](std::size_t A, std::size_t B)
+        {
+            return vertical ? points[A].x() < points[B].x() : points[A].y() < points[B].y();
+        }
+    );
+
+    _vertical[mid] = vertical;
+    _alive[mid]    = hi - lo;
+
+    _build(lo, mid, points);
+    _build(mid + 1UL, hi, points);
+}
+
+// Operations:
+void KDTree::remove(std::size_t id)
+{
+    if (_removed[id])
+        return;
+
+    _removed[id] = true;
+
+    _erase(_position[id]);
+}
+
+void KDTree::_erase(std::size_t position)
+{
+    _masked[position] = 1U;
+
+    if (position >= _tree)
+    {
+        _tail--;
+
+        return;
+    }
+
+    for (std::size_t lo = 0UL, hi = _tree; lo < hi; )
+    {
+        if (hi - lo <= bucket)
+        {
+            _alive[lo]--;
+
+            break;
+        }
+
+        const std::size_t mid = (lo + hi) / 2UL;
+
+        _alive[mid]--;
+
+        if (position == mid)
+            break;
+
+        if (position < mid)
+            hi = mid;
+        else
+            lo = mid + 1UL;
+    }
+}
+
+// Queries:
+template <typename Heap>
+void KDTree::_nearest
+(
+    std::size_t lo,
+    std::size_t hi,
+    double x,
+    double y,
+    std::size_t k,
+    std::size_t exclude,
+    Heap& heap
+) const
+{
+    if (lo >= hi)
+        return;
+
+    auto offer = [&heap, k](double d, std::size_t id)
+    {
+        if (heap.size() < k)
+            heap.emplace(d, id);
+        else if (d < heap.top().first)
+        {
+            heap.pop(); heap.emplace(d, id);
+        }
+    };
+
+    if (hi - lo <= bucket)
+    {
+        if (_alive[lo] == 0UL)
+            return;
+
+        double distances[bucket];
+
+        Simd::squared(_points.xs() + lo, _points.ys() + lo, x, y, hi - lo, distances);
+
+        for (std::size_t p = lo; p < hi; p++)
+            if (!_masked[p] && _ids[p] != exclude)
+                offer(distances[p - lo], _ids[p]);
+
+        return;
+    }
+
+    const std::size_t mid = (lo + hi) / 2UL;
+
+    if (_alive[mid] == 0UL)
+        return;
+
+    const std::size_t id = _ids[mid];
+
+    if (!_masked[mid] && id != exclude)
+    {
+        const double dx = _points.x(mid) - x, dy = _points.y(mid) - y;
+
+        offer(dx * dx + dy * dy, id);
+    }
+
+    const double diff = _vertical[mid] ? x - _points.x(mid) : y - _points.y(mid);
+
+    const std::size_t nlo = diff < 0.0 ? lo : mid + 1UL, nhi = diff < 0.0 ? mid : hi;
+    const std::size_t flo = diff < 0.0 ? mid + 1UL : lo, fhi = diff < 0.0 ? hi : mid;
+
+    _nearest(nlo, nhi, x, y, k, exclude, heap);
+
+    // The far side may only be skipped if it lies beyond the k-th nearest point
+    if (heap.size() < k || diff * diff < heap.top().first)
+        _nearest(flo, fhi, x, y, k, exclude, heap);
+}
+
+std::vector<std::size_t> KDTree::nearest(const Vector2& point, std::size_t k, std::size_t exclude) const
+{
+    std::priority_queue<std::pair<double, std::size_t>> heap;
+
+    if (k > 0UL)
+        _nearest(0UL, _tree, point.x(), point.y(), k, exclude, heap);
+
+    for (std::size_t p = _tree; p < _ids.size() && k > 0UL; p++)
+    {
+        if (_masked[p] || _ids[p] == exclude)
+            continue;
+
+        const double dx = _points.x(p) - point.x(), dy = _points.y(p) - point.y(), d = dx * dx + dy * dy;
+
+        if (heap.size() < k)
+            heap.emplace(d, _ids[p]);
+        else if (d < heap.top().first)
+        {
+            heap.pop(); heap.emplace(d, _ids[p]);
+        }
+    }
+
+    std::vector<std::size_t> ids(heap.size());
+    for (std::size_t r = ids.size(); r-- > 0UL; heap.pop())
+        ids[r] = heap.top().second;
+
+    return ids;
+}
+
+std::size_t KDTree::nearest(const Vector2& point) const
+{
+    const std::vector<std::size_t> ids = nearest(point, 1UL);
+
+    return ids.empty() ? size() : ids.front();
+}
@@ -0,0 +1,185 @@
+
+#include "matrix.hpp"
+#include <functional>   // std::function
+#include <vector>       // std::vector
+#include <utility>      // std::pair
+#include <algorithm>    // std::copy
+#include <memory>       // std::unique_ptr, std::shared_ptr, std::make_shared
+#include <limits>       // std::numeric_limits
+#include <mutex>        // std::lock_guard
+#include <cstdint>      // std::uintptr_t
+
+// Constructors:
+DistanceMatrix::DistanceMatrix()
+:
+_size(0UL), _stride(0UL),
+_function(),
+_storage(), _shared(), _data(nullptr),
+_rows(), _cache(), _mutex(), _capacity(0UL), _exhausted(false),
+_base(), _map(), _appended()
+{
+}
+
+DistanceMatrix::DistanceMatrix(std::size_t _size, const std::shared_ptr<const double>& _shared)
+:
+_size(_size), _stride(stride(_size)),
+_function(),
+_storage(), _shared(_shared), _data(_shared.get()),
+_rows(), _cache(), _mutex(), _capacity(0UL), _exhausted(false),
+_base(), _map(), _appended()
+{
+}
+
+DistanceMatrix::DistanceMatrix
+(
+    const std::shared_ptr<const DistanceMatrix>& base,
+    const std::vector<std::size_t>& ids,
+    std::size_t _size,
+    const Function& _function,
+    std::size_t budget
+)
+:
+_size(_size),
+_stride(stride(_size)),
+_function(_function),
+_storage(), _shared(), _data(nullptr),
+_rows(), _cache(), _mutex(), _capacity(0UL), _exhausted(false),
+_base(), _map(), _appended()
+{
+    const std::size_t m = ids.size();
+
+    // A view of a view shares the root of the latter
+    const std::shared_ptr<const DistanceMatrix>& root = base->_base ? base->_base : base;
+
+    const std::size_t appended = base->_appended.size() + (_size - m), total = root->size() + appended;
+
+    if (4UL * (total - _size + appended) <= total)
+    {
+        _base = root;
+
+        _map.reserve(_size);
+        for (const auto id : ids)
+            _map.push_back(base->_base ? base->_map[id] : id);
+
+        _appended = base->_appended;
+
+        // The durations from and to the ids left out of the root are never looked up
+        for (std::size_t i = m; i < _size; i++)
+        {
+            const std::size_t a = root->size() + _appended.size();
+
+            const auto durations = std::make_shared<Appended>();
+
+            durations->from.assign(a + 1UL, std::numeric_limits<double>::quiet_NaN());
+            durations->to.assign(a + 1UL, std::numeric_limits<double>::quiet_NaN());
+
+            for (std::size_t j = 0UL; j < i; j++)
+            {
+                durations->from[_map[j]] = _function(i, j);
+                durations->to[_map[j]]   = _function(j, i);
+            }
+
+            durations->from[a] = durations->to[a] = _function(i, i);
+
+            _map.push_back(a); _appended.push_back(durations);
+        }
+
+        return;
+    }
+
+    double * data = _allocate(budget);
+
+    // Lazily filled rows are evaluated by the function alone
+    if (!data)
+        return;
+
+    // The ids of the base are usually kept in order, barring a few removed,
+    // hence the rows are copied in contiguous runs where possible
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+
+    for (std::size_t j = 0UL; j < m; j++)
+        if (runs.empty() || ids[j] != ids[j - 1UL] + 1UL)
+            runs.emplace_back(j, 1UL);
+        else
+            runs.back().second++;
+
+    for (std::size_t i = 0UL; i < _size; i++)
+    {
+        double * row = data + i * _stride;
+
+        if (i < m)
+        {
+            const double * other = base->dense() ? base->row(ids[i]) : nullptr;
+
+            if (other)
+                for (const auto& run : runs)
+                    std::copy(other + ids[run.first], other + ids[run.first] + run.second, row + run.first);
+            else
+                for (std::size_t j = 0UL; j < m; j++)
+                    row[j] = base->peek(ids[i], ids[j]);
+        }
+        else
+        {
+            for (std::size_t j = 0UL; j < m; j++)
+                row[j] = _function(i, j);
+        }
+
+        for (std::size_t j = m; j < _size; j++)
+            row[j] = _function(i, j);
+    }
+}
+
+double * DistanceMatrix::_allocate(std::size_t budget)
+{
+    if (_size * _stride * sizeof(double) <= budget)
+    {
+        _storage.resize(_size * _stride + 8UL);
+
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(_storage.data());
+
+        double * data = _storage.data() + ((64UL - address % 64UL) % 64UL) / sizeof(double);
+
+        _data = data;
+
+        return data;
+    }
+
+    _rows.reset(new std::atomic<const double *>[_size]);
+
+    for (std::size_t i = 0UL; i < _size; i++)
+        _rows[i].store(nullptr, std::memory_order_relaxed);
+
+    _capacity = budget / (_size * sizeof(double));
+
+    return nullptr;
+}
+
+// Lazy row cache:
+const double * DistanceMatrix::_fill(std::size_t i) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // Another thread may have filled the row in the meantime
+    const double * row = _rows[i].load(std::memory_order_relaxed);
+
+    if (row)
+        return row;
+
+    if (_cache.size() >= _capacity)
+    {
+        _exhausted.store(true, std::memory_order_relaxed);
+
+        return nullptr;
+    }
+
+    std::unique_ptr<double[]> values(new double[_size]);
+
+    for (std::size_t j = 0UL; j < _size; j++)
+        values[j] = _function(i, j);
+
+    row = values.get(); _cache.push_back(std::move(values));
+
+    _rows[i].store(row, std::memory_order_release);
+
+    return row;
+}
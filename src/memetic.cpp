@@ -0,0 +1,204 @@
+#include "memetic.hpp"
+#include <vector>       // std::vector
+#include <utility>      // std::pair, std::make_pair, std::move
+#include <algorithm>    // std::sort, std::rotate
+
+namespace
+{
+    // Removes the s-th of the first count entries by moving the last of them in its place
+    std::size_t take(std::array<std::size_t, 2>& list, std::size_t& count, std::size_t s)
+    {
+        const std::size_t id = list[s];
+
+        list[s] = list[--count];
+
+        return id;
+    }
+
+    void erase(std::array<std::size_t, 2>& list, std::size_t& count, std::size_t id)
+    {
+        for (std::size_t s = 0UL; s < count; s++)
+        {
+            if (list[s] == id)
+            {
+                take(list, count, s); return;
+            }
+        }
+    }
+
+    bool linked(const Memetic::Links& links, std::size_t a, std::size_t b)
+    {
+        return links[a][0] == b || links[a][1] == b;
+    }
+}
+
+Memetic::Links Memetic::links(const std::vector<std::size_t>& route)
+{
+    const std::size_t n = route.size();
+
+    Links links(n);
+
+    for (std::size_t i = 0UL; i < n; i++)
+    {
+        links[route[i]][0] = route[i == 0UL ? n - 1UL : i - 1UL];
+        links[route[i]][1] = route[i + 1UL == n ? 0UL : i + 1UL];
+    }
+
+    return links;
+}
+
+// Every id is left with as many edges of the first parent as of the second one, hence a random walk
+// alternating between them never gets stuck, until it revisits an id at a position of the same
+// parity, closing an AB-cycle. The cycle is split off and the walk resumes from where it started.
+// Directed cycles leave every id by its successor in the first parent and arrive at the next one
+// from its predecessor in the second, hence are uniquely determined
+std::vector<Memetic::Cycle> Memetic::cycles(const Links& A, const Links& B, bool directed, Random& random)
+{
+    const std::size_t n = A.size(), none = n;
+
+    std::vector<Cycle> cycles;
+
+    if (directed)
+    {
+        std::vector<bool> visited(n, false);
+
+        for (std::size_t start = 0UL; start < n; start++)
+        {
+            if (visited[start] || A[start][1] == B[start][1])
+                continue;
+
+            Cycle cycle; std::size_t v = start;
+
+            do
+            {
+                const std::size_t a = A[v][1], w = B[a][0];
+
+                cycle.removed.emplace_back(v, a); cycle.added.emplace_back(w, a);
+
+                visited[v] = true; v = w;
+            }
+            while (v != start);
+
+            cycles.push_back(std::move(cycle));
+        }
+
+        return cycles;
+    }
+
+    // The edges of either parent missing from the other, yet to be walked
+    std::vector<std::array<std::size_t, 2>> ra(n), rb(n);
+
+    std::vector<std::size_t> ca(n, 0UL), cb(n, 0UL);
+
+    for (std::size_t v = 0UL; v < n; v++)
+    {
+        for (std::size_t s = 0UL; s < 2UL; s++)
+        {
+            if (!linked(B, v, A[v][s])) ra[v][ca[v]++] = A[v][s];
+            if (!linked(A, v, B[v][s])) rb[v][cb[v]++] = B[v][s];
+        }
+    }
+
+    // The position of every id along the walk, per parity
+    std::vector<std::size_t> path, position(2UL * n, none);
+
+    for (std::size_t start = 0UL; start < n; start++)
+    {
+        while (ca[start] > 0UL)
+        {
+            path.clear(); path.push_back(start); position[2UL * start] = 0UL;
+
+            while (path.size() > 1UL || ca[start] > 0UL)
+            {
+                const std::size_t k = path.size() - 1UL, v = path[k];
+
+                // The edges of the first parent leave the even positions
+                const bool a = k % 2UL == 0UL;
+
+                std::size_t& count = a ? ca[v] : cb[v];
+
+                if (count == 0UL)
+                    break;
+
+                const std::size_t u = take(a ? ra[v] : rb[v], count, random.below(count));
+
+                if (a)
+                    erase(ra[u], ca[u], v);
+                else
+                    erase(rb[u], cb[u], v);
+
+                path.push_back(u);
+
+                const std::size_t parity = (k + 1UL) % 2UL, q = position[2UL * u + parity];
+
+                if (q == none)
+                {
+                    position[2UL * u + parity] = k + 1UL; continue;
+                }
+
+                Cycle cycle;
+
+                for (std::size_t i = q; i + 1UL < path.size(); i++)
+                    (i % 2UL == 0UL ? cycle.removed : cycle.added).emplace_back(path[i], path[i + 1UL]);
+
+                // The id closing the cycle stays on the walk at position q
+                for (std::size_t i = q + 1UL; i + 1UL < path.size(); i++)
+                    position[2UL * path[i] + i % 2UL] = none;
+
+                path.resize(q + 1UL);
+
+                cycles.push_back(std::move(cycle));
+            }
+
+            for (std::size_t i = 0UL; i < path.size(); i++)
+                position[2UL * path[i] + i % 2UL] = none;
+        }
+    }
+
+    return cycles;
+}
+
+std::vector<std::size_t> Memetic::order(const Links& links)
+{
+    std::vector<std::size_t> route;
+
+    route.reserve(links.size());
+
+    std::size_t previous = links[0UL][0], current = 0UL;
+
+    do
+    {
+        route.push_back(current);
+
+        const std::size_t next = links[current][0] == previous ? links[current][1] : links[current][0];
+
+        previous = current; current = next;
+    }
+    while (current != 0UL && route.size() < links.size());
+
+    return route;
+}
+
+// Double bridges, which the local search hardly undoes: the route A B C D becomes A C B D
+void Memetic::perturb(std::vector<std::size_t>& route, std::size_t kicks, Random& random)
+{
+    const std::size_t n = route.size();
+
+    if (n < 8UL)
+        return;
+
+    for (std::size_t kick = 0UL; kick < kicks; kick++)
+    {
+        std::size_t cuts[3];
+
+        for (std::size_t& cut : cuts)
+            cut = 1UL + random.below(n);
+
+        std::sort(cuts, cuts + 3);
+
+        if (cuts[0] == cuts[1] || cuts[1] == cuts[2])
+            continue;
+
+        std::rotate(route.begin() + cuts[0], route.begin() + cuts[1], route.begin() + cuts[2]);
+    }
+}
@@ -0,0 +1,113 @@
+#include "tsp.hpp"
+#include "vector2.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+
+// Compares the type erased (std::function) cost policies of tsp and tsptw
+// against the very same lambdas passed as compile-time policies.
+//
+// Usage: POLICIES [SIZE] [REPETITIONS]
+
+template <typename F>
+double milliseconds(std::size_t repetitions, const F& f)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t r = 0UL; r < repetitions; r++)
+        f();
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+void report(const std::string& name, double erased, double inlined)
+{
+    std::cout
+    << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+    << std::setw(12) << erased << " ms"
+    << std::setw(12) << inlined << " ms"
+    << std::setw(9) << std::setprecision(2) << erased / inlined << "x" << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    std::size_t SIZE = 2000UL, REPETITIONS = 5UL;
+
+    if (argc > 1)
+        std::istringstream(argv[1]) >> SIZE;
+
+    if (argc > 2)
+        std::istringstream(argv[2]) >> REPETITIONS;
+
+    std::mt19937_64 engine(1UL);
+    std::uniform_real_distribution<double> coordinate(-100.0, 100.0), open(0.0, 3600.0);
+
+    std::vector<Vector2> points; std::map<Vector2, tsptw<Vector2>::Timewindow> timewindows;
+
+    for (std::size_t i = 0; i < SIZE; i++)
+    {
+        points.emplace_back(coordinate(engine), coordinate(engine));
+
+        const double start = open(engine);
+
+        timewindows[points.back()] = tsptw<Vector2>::Timewindow(start, start + 3600.0);
+    }
+
+    const Vector2 depot(0.0, 0.0);
+
+    // The same lambdas as the ones of src/tsp.cpp and src/tsptw.cpp
+    auto euclidean2 =
+    [](const Vector2& A, const Vector2& B)
+    {
+        double xdiff = A.x() - B.x();
+        double ydiff = A.y() - B.y();
+
+        return xdiff * xdiff + ydiff * ydiff;
+    };
+
+    auto service = [&depot](const Vector2& v) { return v == depot ? 0.0 : 30.0; };
+
+    auto timewindow = [&timewindows, &depot](const Vector2& point)
+    {
+        return point == depot ? tsptw<Vector2>::Timewindow(0.0, 86400.0) : timewindows.at(point);
+    };
+
+    std::cout
+    << "Stops: " << SIZE << "\n\n"
+    << std::left << std::setw(28) << "" << std::right
+    << std::setw(15) << "std::function" << std::setw(15) << "inlined" << std::setw(10) << "speedup" << std::endl;
+
+    // Every duration is evaluated once, when the matrix is built
+    report
+    (
+        "tsp construction",
+        milliseconds(REPETITIONS, [&]() { tsp<Vector2>(depot, points, service, euclidean2, true); }),
+        milliseconds(REPETITIONS, [&]() { make_tsp(depot, points, service, euclidean2, true); })
+    );
+
+    report
+    (
+        "tsptw construction",
+        milliseconds(REPETITIONS, [&]() { tsptw<Vector2>(depot, points, service, euclidean2, 0.0, timewindow, true); }),
+        milliseconds(REPETITIONS, [&]() { make_tsptw(depot, points, service, euclidean2, 0.0, timewindow, true); })
+    );
+
+    // Thereafter the solvers only ever look the matrix up
+    const tsp<Vector2> erased(depot, points, service, euclidean2, true);
+    const auto inlined = make_tsp(depot, points, service, euclidean2, true);
+
+    report
+    (
+        "tsp nneighbour + opt2",
+        milliseconds(REPETITIONS, [&]() { erased.nneighbour().opt2(); }),
+        milliseconds(REPETITIONS, [&]() { inlined.nneighbour().opt2(); })
+    );
+
+    return 0;
+}
@@ -0,0 +1,414 @@
+
+#include "simd.hpp"
+#include "vector2.hpp"
+#include <vector>       // std::vector
+#include <limits>       // std::numeric_limits
+#include <cstring>      // std::memcpy, std::strcmp
+#include <cstdlib>      // std::getenv
+#include <algorithm>    // std::min
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define __SIMD_X86__
+    #include <immintrin.h>
+#endif
+
+namespace
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // Scalar:
+    void squaredScalar(const double * xs, const double * ys, double x, double y, std::size_t n, double * out)
+    {
+        for (std::size_t i = 0UL; i < n; i++)
+        {
+            const double dx = xs[i] - x, dy = ys[i] - y;
+
+            out[i] = dx * dx + dy * dy;
+        }
+    }
+
+    // Continues the search of the minimum from the specified index onwards
+    std::size_t argminScalar(const double * values, const std::uint8_t * mask, std::size_t n, std::size_t i, std::size_t best, double minimum)
+    {
+        for (; i < n; i++)
+        {
+            if (!mask[i] && values[i] < minimum)
+            {
+                minimum = values[i]; best = i;
+            }
+        }
+
+        return best;
+    }
+
+    std::size_t nearestScalar(const double * xs, const double * ys, double x, double y, const std::uint8_t * mask, std::size_t n, std::size_t i, std::size_t best, double minimum)
+    {
+        for (; i < n; i++)
+        {
+            const double dx = xs[i] - x, dy = ys[i] - y, d = dx * dx + dy * dy;
+
+            if (!mask[i] && d < minimum)
+            {
+                minimum = d; best = i;
+            }
+        }
+
+        return best;
+    }
+
+    std::size_t argminScalar(const double * values, const std::uint8_t * mask, std::size_t n)
+    {
+        return argminScalar(values, mask, n, 0UL, n, infinity);
+    }
+
+    std::size_t nearestScalar(const double * xs, const double * ys, double x, double y, const std::uint8_t * mask, std::size_t n)
+    {
+        return nearestScalar(xs, ys, x, y, mask, n, 0UL, n, infinity);
+    }
+
+    #ifdef __SIMD_X86__
+
+    // The vectorised argmin takes two passes; the first finds the minimum by means
+    // of independent accumulators and the second the first index holding it.
+    // Values provides the values of consecutive indices, either a vector or one at a time
+
+    // SSE2:
+    struct ValuesSSE2
+    {
+        const double * values;
+
+        __attribute__((target("sse2")))
+        __m128d operator()(std::size_t i) const { return _mm_loadu_pd(values + i); }
+
+        double at(std::size_t i) const { return values[i]; }
+    };
+
+    struct DistancesSSE2
+    {
+        const double * xs, * ys;
+
+        double x, y;
+
+        __attribute__((target("sse2")))
+        __m128d operator()(std::size_t i) const
+        {
+            const __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + i), _mm_set1_pd(x));
+            const __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + i), _mm_set1_pd(y));
+
+            return _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        }
+
+        double at(std::size_t i) const
+        {
+            const double dx = xs[i] - x, dy = ys[i] - y;
+
+            return dx * dx + dy * dy;
+        }
+    };
+
+    // All bits set in the lanes whose mask is zero
+    __attribute__((target("sse2")))
+    inline __m128d validSSE2(const std::uint8_t * mask)
+    {
+        return _mm_castsi128_pd(_mm_set_epi64x(mask[1] ? 0LL : -1LL, mask[0] ? 0LL : -1LL));
+    }
+
+    __attribute__((target("sse2")))
+    inline __m128d maskedSSE2(__m128d values, const std::uint8_t * mask)
+    {
+        const __m128d valid = validSSE2(mask);
+
+        return _mm_or_pd(_mm_and_pd(valid, values), _mm_andnot_pd(valid, _mm_set1_pd(infinity)));
+    }
+
+    __attribute__((target("sse2")))
+    void squaredSSE2(const double * xs, const double * ys, double x, double y, std::size_t n, double * out)
+    {
+        const DistancesSSE2 distances{ xs, ys, x, y };
+
+        std::size_t i = 0UL;
+        for (; i + 2UL <= n; i += 2UL)
+            _mm_storeu_pd(out + i, distances(i));
+
+        for (; i < n; i++)
+            out[i] = distances.at(i);
+    }
+
+    template <typename Values>
+    __attribute__((target("sse2")))
+    std::size_t argminSSE2(const Values& values, const std::uint8_t * mask, std::size_t n)
+    {
+        __m128d m0 = _mm_set1_pd(infinity), m1 = m0;
+
+        std::size_t i = 0UL;
+        for (; i + 4UL <= n; i += 4UL)
+        {
+            m0 = _mm_min_pd(m0, maskedSSE2(values(i), mask + i));
+            m1 = _mm_min_pd(m1, maskedSSE2(values(i + 2UL), mask + i + 2UL));
+        }
+
+        double lanes[2]; _mm_storeu_pd(lanes, _mm_min_pd(m0, m1));
+
+        double minimum = std::min(lanes[0], lanes[1]);
+
+        for (; i < n; i++)
+            if (!mask[i])
+                minimum = std::min(minimum, values.at(i));
+
+        if (!(minimum < infinity))
+            return n;
+
+        const __m128d target = _mm_set1_pd(minimum);
+
+        for (i = 0UL; i + 2UL <= n; i += 2UL)
+        {
+            const int bits = _mm_movemask_pd(_mm_and_pd(_mm_cmpeq_pd(values(i), target), validSSE2(mask + i)));
+
+            if (bits)
+                return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(bits)));
+        }
+
+        for (; i < n; i++)
+            if (!mask[i] && values.at(i) == minimum)
+                return i;
+
+        return n;
+    }
+
+    __attribute__((target("sse2")))
+    std::size_t argminSSE2(const double * values, const std::uint8_t * mask, std::size_t n)
+    {
+        return argminSSE2(ValuesSSE2{ values }, mask, n);
+    }
+
+    __attribute__((target("sse2")))
+    std::size_t nearestSSE2(const double * xs, const double * ys, double x, double y, const std::uint8_t * mask, std::size_t n)
+    {
+        return argminSSE2(DistancesSSE2{ xs, ys, x, y }, mask, n);
+    }
+
+    // AVX2:
+    struct ValuesAVX2
+    {
+        const double * values;
+
+        __attribute__((target("avx2")))
+        __m256d operator()(std::size_t i) const { return _mm256_loadu_pd(values + i); }
+
+        double at(std::size_t i) const { return values[i]; }
+    };
+
+    struct DistancesAVX2
+    {
+        const double * xs, * ys;
+
+        double x, y;
+
+        __attribute__((target("avx2")))
+        __m256d operator()(std::size_t i) const
+        {
+            const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), _mm256_set1_pd(x));
+            const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), _mm256_set1_pd(y));
+
+            return _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        }
+
+        double at(std::size_t i) const
+        {
+            const double dx = xs[i] - x, dy = ys[i] - y;
+
+            return dx * dx + dy * dy;
+        }
+    };
+
+    // All bits set in the lanes whose mask, out of the lowest four bytes specified, is zero
+    __attribute__((target("avx2")))
+    inline __m256d validAVX2(__m128i bytes)
+    {
+        const __m256i wide = _mm256_cvtepu8_epi64(bytes);
+
+        return _mm256_castsi256_pd(_mm256_cmpeq_epi64(wide, _mm256_setzero_si256()));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m128i bytesAVX2(const std::uint8_t * mask)
+    {
+        std::int32_t bytes; std::memcpy(&bytes, mask, sizeof(bytes));
+
+        return _mm_cvtsi32_si128(bytes);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256d maskedAVX2(__m256d values, __m128i bytes)
+    {
+        return _mm256_blendv_pd(_mm256_set1_pd(infinity), values, validAVX2(bytes));
+    }
+
+    __attribute__((target("avx2")))
+    void squaredAVX2(const double * xs, const double * ys, double x, double y, std::size_t n, double * out)
+    {
+        const DistancesAVX2 distances{ xs, ys, x, y };
+
+        std::size_t i = 0UL;
+        for (; i + 4UL <= n; i += 4UL)
+            _mm256_storeu_pd(out + i, distances(i));
+
+        for (; i < n; i++)
+            out[i] = distances.at(i);
+    }
+
+    template <typename Values>
+    __attribute__((target("avx2")))
+    std::size_t argminAVX2(const Values& values, const std::uint8_t * mask, std::size_t n)
+    {
+        __m256d m0 = _mm256_set1_pd(infinity), m1 = m0, m2 = m0, m3 = m0;
+
+        std::size_t i = 0UL;
+        for (; i + 16UL <= n; i += 16UL)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i));
+
+            m0 = _mm256_min_pd(m0, maskedAVX2(values(i),        bytes));
+            m1 = _mm256_min_pd(m1, maskedAVX2(values(i + 4UL),  _mm_srli_si128(bytes, 4)));
+            m2 = _mm256_min_pd(m2, maskedAVX2(values(i + 8UL),  _mm_srli_si128(bytes, 8)));
+            m3 = _mm256_min_pd(m3, maskedAVX2(values(i + 12UL), _mm_srli_si128(bytes, 12)));
+        }
+
+        for (; i + 4UL <= n; i += 4UL)
+            m0 = _mm256_min_pd(m0, maskedAVX2(values(i), bytesAVX2(mask + i)));
+
+        double lanes[4]; _mm256_storeu_pd(lanes, _mm256_min_pd(_mm256_min_pd(m0, m1), _mm256_min_pd(m2, m3)));
+
+        double minimum = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+
+        for (; i < n; i++)
+            if (!mask[i])
+                minimum = std::min(minimum, values.at(i));
+
+        if (!(minimum < infinity))
+            return n;
+
+        const __m256d target = _mm256_set1_pd(minimum);
+
+        for (i = 0UL; i + 4UL <= n; i += 4UL)
+        {
+            const __m256d equal = _mm256_cmp_pd(values(i), target, _CMP_EQ_OQ);
+
+            const int bits = _mm256_movemask_pd(_mm256_and_pd(equal, validAVX2(bytesAVX2(mask + i))));
+
+            if (bits)
+                return i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(bits)));
+        }
+
+        for (; i < n; i++)
+            if (!mask[i] && values.at(i) == minimum)
+                return i;
+
+        return n;
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t argminAVX2(const double * values, const std::uint8_t * mask, std::size_t n)
+    {
+        return argminAVX2(ValuesAVX2{ values }, mask, n);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t nearestAVX2(const double * xs, const double * ys, double x, double y, const std::uint8_t * mask, std::size_t n)
+    {
+        return argminAVX2(DistancesAVX2{ xs, ys, x, y }, mask, n);
+    }
+
+    #endif
+
+    struct Kernels
+    {
+        const char * isa;
+
+        void (*squared)(const double *, const double *, double, double, std::size_t, double *);
+
+        std::size_t (*argmin)(const double *, const std::uint8_t *, std::size_t);
+
+        std::size_t (*nearest)(const double *, const double *, double, double, const std::uint8_t *, std::size_t);
+    };
+
+    Kernels dispatch()
+    {
+        const char * cap = std::getenv("TSP_ISA");
+
+        auto allowed = [cap](const char * isa)
+        {
+            if (!cap)
+                return true;
+
+            // The instruction sets in ascending order of preference
+            for (const char * other : { "scalar", "sse2", "avx2" })
+            {
+                if (std::strcmp(other, isa) == 0)
+                    return true;
+
+                if (std::strcmp(other, cap) == 0)
+                    return false;
+            }
+
+            return true;
+        };
+
+        #ifdef __SIMD_X86__
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2") && allowed("avx2"))
+            return Kernels{ "avx2", squaredAVX2, argminAVX2, nearestAVX2 };
+
+        if (__builtin_cpu_supports("sse2") && allowed("sse2"))
+            return Kernels{ "sse2", squaredSSE2, argminSSE2, nearestSSE2 };
+        #endif
+
+        return Kernels{ "scalar", squaredScalar, argminScalar, nearestScalar };
+    }
+
+    const Kernels& kernels()
+    {
+        static const Kernels instance = dispatch();
+
+        return instance;
+    }
+}
+
+// Namespace Simd:
+const char * Simd::isa()
+{
+    return kernels().isa;
+}
+
+void Simd::squared(const double * xs, const double * ys, double x, double y, std::size_t n, double * out)
+{
+    kernels().squared(xs, ys, x, y, n, out);
+}
+
+std::size_t Simd::argmin(const double * values, const std::uint8_t * mask, std::size_t n)
+{
+    return kernels().argmin(values, mask, n);
+}
+
+std::size_t Simd::nearest(const double * xs, const double * ys, double x, double y, const std::uint8_t * mask, std::size_t n)
+{
+    return kernels().nearest(xs, ys, x, y, mask, n);
+}
+
+// Class Points:
+Points::Points()
+:
+_x(), _y()
+{
+}
+
+Points::Points(const std::vector<Vector2>& points)
+:
+_x(points.size()), _y(points.size())
+{
+    for (std::size_t i = 0UL; i < points.size(); i++)
+    {
+        _x[i] = points[i].x(); _y[i] = points[i].y();
+    }
+}
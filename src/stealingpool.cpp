@@ -0,0 +1,113 @@
+#include "stealingpool.hpp"
+#include <functional>   // std::function
+#include <mutex>        // std::unique_lock, std::lock_guard
+#include <utility>      // std::move
+
+namespace
+{
+    // The pool the current thread works for, if any, and its index therein
+    thread_local const WorkStealingPool * owner = nullptr;
+
+    thread_local std::size_t index = 0UL;
+}
+
+// Constructors:
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+:
+_queues(), _workers(), _mutex(), _condition(), _pending(0UL), _stopping(false), _next(0UL)
+{
+    for (std::size_t t = 0UL; t < threads; t++)
+        _queues.emplace_back(new Queue());
+
+    for (std::size_t t = 0UL; t < threads; t++)
+        _workers.emplace_back(&WorkStealingPool::_work, this, t);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stopping = true;
+    }
+
+    _condition.notify_all();
+
+    for (auto& worker : _workers)
+        worker.join();
+}
+
+// Scheduling:
+void WorkStealingPool::_push(std::function<void()>&& task)
+{
+    const std::size_t q = owner == this ? index : _next++ % _queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+
+        _queues[q]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _pending++;
+    }
+
+    _condition.notify_one();
+}
+
+bool WorkStealingPool::_pop(std::size_t self, std::function<void()>& task)
+{
+    for (std::size_t offset = 0UL; offset < _queues.size(); offset++)
+    {
+        Queue& queue = *_queues[(self + offset) % _queues.size()];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty())
+            continue;
+
+        // The newest task of its own deque or the oldest one of another
+        if (offset == 0UL)
+        {
+            task = std::move(queue.tasks.back()); queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front()); queue.tasks.pop_front();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+// Workers:
+void WorkStealingPool::_work(std::size_t self)
+{
+    owner = this; index = self;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _condition.wait(lock, [this]() { return _stopping || _pending > 0UL; });
+
+            if (_pending == 0UL)
+                return;
+
+            // Claiming one of the pending tasks guarantees that it is found below
+            _pending--;
+        }
+
+        std::function<void()> task;
+
+        while (!_pop(self, task))
+            std::this_thread::yield();
+
+        task();
+    }
+}
@@ -0,0 +1,51 @@
+
+#include "threadpool.hpp"
+#include <functional>   // std::function
+#include <mutex>        // std::unique_lock
+#include <utility>      // std::move
+
+// Constructors:
+ThreadPool::ThreadPool(std::size_t threads)
+:
+_workers(), _tasks(), _mutex(), _condition(), _stopping(false)
+{
+    for (std::size_t t = 0UL; t < threads; t++)
+        _workers.emplace_back(&ThreadPool::_work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _stopping = true;
+    }
+
+    _condition.notify_all();
+
+    for (auto& worker : _workers)
+        worker.join();
+}
+
+// Workers:
+void ThreadPool::_work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+            // Pending tasks are still executed before stopping
+            if (_tasks.empty())
+                return;
+
+            task = std::move(_tasks.front()); _tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,250 @@
+
+#include "tour.hpp"
+#include <vector>       // std::vector
+#include <utility>      // std::swap
+#include <stdexcept>    // std::invalid_argument
+#include <algorithm>    // std::reverse, std::max
+#include <cmath>        // std::sqrt
+
+// Constructors:
+ArrayTour::ArrayTour()
+:
+_order(), _position()
+{
+}
+
+ArrayTour::ArrayTour(const std::vector<std::size_t>& _order)
+:
+_order(_order), _position(_order.size(), _order.size())
+{
+    for (std::size_t p = 0UL; p < _order.size(); p++)
+    {
+        if (_order[p] >= _order.size() || _position[_order[p]] != _order.size())
+            throw std::invalid_argument("tour is not a permutation of [0, n)");
+
+        _position[_order[p]] = p;
+    }
+}
+
+// Queries:
+bool ArrayTour::between(std::size_t a, std::size_t b, std::size_t c) const
+{
+    const std::size_t pa = _position[a], pb = _position[b], pc = _position[c];
+
+    return pa <= pc ? (pa <= pb && pb <= pc) : (pb >= pa || pb <= pc);
+}
+
+std::vector<std::size_t> ArrayTour::order(std::size_t first) const
+{
+    std::vector<std::size_t> ids; ids.reserve(_order.size());
+
+    for (std::size_t p = _position[first]; ids.size() < _order.size(); p = (p + 1UL) % _order.size())
+        ids.push_back(_order[p]);
+
+    return ids;
+}
+
+// Operations:
+void ArrayTour::reverse(std::size_t from, std::size_t to)
+{
+    const std::size_t n = _order.size();
+
+    std::size_t i = _position[from], j = _position[to];
+    std::size_t length = (j + n - i) % n + 1UL;
+
+    // Reversing the complementary path results in the same cycle
+    if (2UL * length > n)
+    {
+        const std::size_t k = i;
+
+        i = (j + 1UL) % n; j = (k + n - 1UL) % n; length = n - length;
+    }
+
+    for (std::size_t s = 0UL; s < length / 2UL; s++)
+    {
+        std::swap(_order[i], _order[j]);
+
+        _position[_order[i]] = i;
+        _position[_order[j]] = j;
+
+        i = (i + 1UL) % n; j = (j + n - 1UL) % n;
+    }
+}
+
+// Class TwoLevelTour:
+constexpr std::size_t TwoLevelTour::threshold;
+
+// Constructors:
+TwoLevelTour::TwoLevelTour()
+:
+_segments(), _order(), _segment(), _offset(), _size(0UL), _group(1UL)
+{
+}
+
+TwoLevelTour::TwoLevelTour(const std::vector<std::size_t>& order)
+:
+_segments(), _order(),
+_segment(order.size(), order.size()), _offset(order.size()),
+_size(order.size()),
+_group(std::max<std::size_t>(8UL, static_cast<std::size_t>(std::sqrt(static_cast<double>(order.size())))))
+{
+    for (const std::size_t id : order)
+    {
+        if (id >= _size || _segment[id] != _size)
+            throw std::invalid_argument("tour is not a permutation of [0, n)");
+
+        _segment[id] = 0UL;
+    }
+
+    _build(order);
+}
+
+void TwoLevelTour::_build(const std::vector<std::size_t>& order)
+{
+    _segments.clear(); _order.clear();
+
+    for (std::size_t first = 0UL; first < order.size(); first += _group)
+    {
+        const std::size_t last = std::min(first + _group, order.size());
+
+        _order.push_back(_segments.size());
+
+        _segments.push_back(Segment{ std::vector<std::size_t>(order.begin() + first, order.begin() + last), false, _order.size() - 1UL });
+
+        for (std::size_t p = first; p < last; p++)
+        {
+            _segment[order[p]] = _order.back();
+            _offset[order[p]]  = p - first;
+        }
+    }
+}
+
+// Queries:
+bool TwoLevelTour::between(std::size_t a, std::size_t b, std::size_t c) const
+{
+    auto key = [this](std::size_t id)
+    {
+        return std::make_pair(_segments[_segment[id]].rank, _position(id));
+    };
+
+    const auto ka = key(a), kb = key(b), kc = key(c);
+
+    return ka <= kc ? (ka <= kb && kb <= kc) : (kb >= ka || kb <= kc);
+}
+
+std::vector<std::size_t> TwoLevelTour::order(std::size_t first) const
+{
+    std::vector<std::size_t> ids; ids.reserve(_size);
+
+    if (_size == 0UL)
+        return ids;
+
+    // Whole segments are traversed at a time, starting from and ending at the one of first
+    const std::size_t rank = _segments[_segment[first]].rank, p = _position(first);
+
+    for (std::size_t r = 0UL; r <= _order.size(); r++)
+    {
+        const Segment& segment = _segments[_order[(rank + r) % _order.size()]];
+
+        const std::size_t lo = r == 0UL ? p : 0UL;
+        const std::size_t hi = r == _order.size() ? p : segment.ids.size();
+
+        for (std::size_t q = lo; q < hi; q++)
+            ids.push_back(_at(segment, q));
+    }
+
+    return ids;
+}
+
+// Operations:
+void TwoLevelTour::_split(std::size_t id)
+{
+    const std::size_t s = _segment[id], p = _position(id), m = _segments[s].ids.size();
+
+    if (p == 0UL)
+        return;
+
+    // The shorter of the two parts, [0, p) or [p, m), is moved to a segment of its own
+    const bool front = p <= m - p;
+
+    const std::size_t lo = front ? 0UL : p, hi = front ? p : m;
+
+    const bool reversed = _segments[s].reversed;
+
+    const std::size_t first = reversed ? m - hi : lo, last = reversed ? m - lo : hi;
+
+    Segment part{ std::vector<std::size_t>(_segments[s].ids.begin() + first, _segments[s].ids.begin() + last), reversed, 0UL };
+
+    _segments[s].ids.erase(_segments[s].ids.begin() + first, _segments[s].ids.begin() + last);
+
+    const std::size_t t = _segments.size(), rank = _segments[s].rank + (front ? 0UL : 1UL);
+
+    _segments.push_back(std::move(part));
+
+    for (std::size_t o = 0UL; o < _segments[t].ids.size(); o++)
+    {
+        _segment[_segments[t].ids[o]] = t;
+        _offset[_segments[t].ids[o]]  = o;
+    }
+
+    for (std::size_t o = 0UL; o < _segments[s].ids.size(); o++)
+        _offset[_segments[s].ids[o]] = o;
+
+    _order.insert(_order.begin() + rank, t);
+
+    for (std::size_t r = rank; r < _order.size(); r++)
+        _segments[_order[r]].rank = r;
+}
+
+void TwoLevelTour::reverse(std::size_t from, std::size_t to)
+{
+    if (from == to)
+        return;
+
+    // The path lies within a single segment
+    if (_segment[from] == _segment[to] && _position(from) <= _position(to))
+    {
+        Segment& segment = _segments[_segment[from]];
+
+        const std::size_t first = std::min(_offset[from], _offset[to]);
+        const std::size_t last  = std::max(_offset[from], _offset[to]);
+
+        std::reverse(segment.ids.begin() + first, segment.ids.begin() + last + 1UL);
+
+        for (std::size_t o = first; o <= last; o++)
+            _offset[segment.ids[o]] = o;
+
+        return;
+    }
+
+    const std::size_t after = next(to);
+
+    // Reversing the whole tour results in the same cycle
+    if (after == from)
+        return;
+
+    _split(from); _split(after);
+
+    std::size_t lo = _segments[_segment[from]].rank, hi = _segments[_segment[to]].rank;
+
+    // Reversing the complementary segments results in the same cycle
+    if (lo > hi)
+    {
+        const std::size_t k = lo;
+
+        lo = hi + 1UL; hi = k - 1UL;
+    }
+
+    std::reverse(_order.begin() + lo, _order.begin() + hi + 1UL);
+
+    for (std::size_t r = lo; r <= hi; r++)
+    {
+        Segment& segment = _segments[_order[r]];
+
+        segment.rank = r; segment.reversed = !segment.reversed;
+    }
+
+    // Every reversal adds at most two segments
+    if (_order.size() > 2UL * (_size / _group) + 8UL)
+        _build(order(_at(_segments[_order.front()], 0UL)));
+}
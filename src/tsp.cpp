@@ -2,13 +2,20 @@
 #include "vector2.hpp"
 #include "tsp.hpp"
 #include "annealing.hpp"
+#include "instrument.hpp"
 
 #include <vector>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <fstream>
+#include <thread>
 #include <algorithm>
 #include <sstream>
+#include <limits>
+#include <map>
+#include <string>
+#include <functional>
 
 template <typename T>
 T str2num(const char *);
@@ -24,8 +31,30 @@ int main(int argc, char * argv[])
         SIZE = str2num<std::size_t>(argv[3]);
     }
 
+    // The initial tour is constructed by the heuristic specified last, if any
+    const std::map<std::string, std::function<tsp<Vector2>(const tsp<Vector2>&)>> constructors
+    {
+        { "NN",      [](const tsp<Vector2>& path) { return path.nneighbour(); } },
+        { "HILBERT", [](const tsp<Vector2>& path) { return path.hilbert(); } },
+        { "GREEDY",  [](const tsp<Vector2>& path) { return path.greedy(); } }
+    };
+
+    const std::string CONSTRUCTOR(argc > 4 ? argv[4] : "NN");
+
+    if (constructors.find(CONSTRUCTOR) == constructors.end())
+    {
+        std::cerr << "<ERR>: Unknown constructor (" << CONSTRUCTOR << ")" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+
     std::srand((unsigned)std::time(nullptr));
 
+    // Run an annealing chain per hardware thread
+    Annealing::Parallel parallel;
+
+    parallel.threads = parallel.chains = std::max(1U, std::thread::hardware_concurrency());
+    parallel.seed    = static_cast<std::uint64_t>(std::time(nullptr));
+
     auto frand = [](double min, double max)
     {
         return min + (max - min) * (static_cast<double>(std::rand()) / static_cast<double>(RAND_MAX));
@@ -47,14 +76,15 @@ int main(int argc, char * argv[])
 
     Vector2 depot(0.0, 0.0);
 
-    tsp<Vector2> path(depot, points, [](const Vector2& v) { return 0.0; }, cost);
+    // The squared distance grows with the euclidean one, hence the stops may be spatially indexed
+    tsp<Vector2> path(depot, points, [](const Vector2& v) { return 0.0; }, cost, true);
     
-    path = path.nneighbour();
+    path = constructors.at(CONSTRUCTOR)(path);
 
     #ifndef __TEST__
-    std::cout << "NN:\n" << path << std::endl;
+    std::cout << CONSTRUCTOR << ":\n" << path << std::endl;
     #else
-    std::cout << "NN: " << path.cost() << std::endl;
+    std::cout << CONSTRUCTOR << ": " << path.cost() << std::endl;
     #endif
 
     path = path.opt2();
@@ -65,7 +95,7 @@ int main(int argc, char * argv[])
     std::cout << "OPT21: " << path.cost() << std::endl;
     #endif
 
-    path = path.sannealing();
+    path = path.sannealing(parallel);
 
     #ifndef __TEST__
     std::cout << "SA:\n" << path << std::endl;
@@ -80,6 +110,34 @@ int main(int argc, char * argv[])
     #else
     std::cout << "OPT22: " << path.cost() << std::endl;
     #endif
+
+    path = path.oropt().or3opt();
+
+    #ifndef __TEST__
+    std::cout << "OROPT:\n" << path << std::endl;
+    #else
+    std::cout << "OROPT: " << path.cost() << std::endl;
+    #endif
+
+    // Iterated Lin-Kernighan for the remainder of a one second budget
+    LocalSearch::Options lk;
+
+    lk.kicks   = std::numeric_limits<std::size_t>::max();
+    lk.seconds = 1.0;
+
+    path = path.linkernighan(lk);
+
+    #ifndef __TEST__
+    std::cout << "LK:\n" << path << std::endl;
+    #else
+    std::cout << "LK: " << path.cost() << std::endl;
+    #endif
+
+    #ifdef __INSTRUMENT__
+    std::ofstream trace("trace.csv");
+
+    Instrument::dump(trace);
+    #endif
 }
 
 template <typename T>
@@ -3,13 +3,41 @@
 #include "tsp.hpp"
 #include "tstamp.hpp"
 #include "vector2.hpp"
+#include "instrument.hpp"
 #include <iostream>
+#include <fstream>
+#include <thread>
 #include <map>
+#include <algorithm>
+#include <string>
+#include <functional>
 
-int main()
+int main(int argc, char * argv[])
 {
+    // The initial route is constructed by the specified heuristic, if any
+    const std::map<std::string, std::function<tsp<Vector2>(const tsptw<Vector2>&)>> constructors
+    {
+        { "NN",      [](const tsptw<Vector2>& path) { return path.nneighbour(); } },
+        { "HILBERT", [](const tsptw<Vector2>& path) { return path.hilbert(); } },
+        { "GREEDY",  [](const tsptw<Vector2>& path) { return path.greedy(); } }
+    };
+
+    const std::string CONSTRUCTOR(argc > 1 ? argv[1] : "NN");
+
+    if (constructors.find(CONSTRUCTOR) == constructors.end())
+    {
+        std::cerr << "<ERR>: Unknown constructor (" << CONSTRUCTOR << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     std::srand((unsigned)std::time(nullptr));
 
+    // Run an annealing chain per hardware thread
+    Annealing::Parallel parallel;
+
+    parallel.threads = parallel.chains = std::max(1U, std::thread::hardware_concurrency());
+    parallel.seed    = static_cast<std::uint64_t>(std::time(nullptr));
+
     auto frand = [](double min, double max)
     {
         return min + (max - min) * (static_cast<double>(std::rand()) / static_cast<double>(RAND_MAX));
@@ -59,16 +87,28 @@ int main()
         },
         euclidean2,
         TStamp(7, 30).seconds(),
-        timewindow
+        timewindow,
+        true
     );
 
-    path = path.nneighbour();
+    path = constructors.at(CONSTRUCTOR)(path);
 
-    std::cout << "NN:\n" << path << std::endl;
+    std::cout << CONSTRUCTOR << ":\n" << path << std::endl;
 
-    path = path.cannealing();
+    path = path.cannealing(parallel);
 
     std::cout << "CA:\n" << path << std::endl;
 
+    // Feasible routes remain feasible
+    path = path.oropt().or3opt();
+
+    std::cout << "OROPT:\n" << path << std::endl;
+
+    #ifdef __INSTRUMENT__
+    std::ofstream trace("trace.csv");
+
+    Instrument::dump(trace);
+    #endif
+
     return 0;
 }